@@ -140,6 +140,75 @@ public class ValidationService : ServiceD.ServiceDBase
         return response;
     }
 
+    public override async Task<ValidationBatchResponse> ValidateBatch(
+        ValidationBatchRequest request,
+        ServerCallContext context)
+    {
+        using var activity = ActivitySource.StartActivity("ValidateBatch");
+        activity?.SetTag("rpc.system", "grpc");
+        activity?.SetTag("rpc.service", "ServiceD");
+        activity?.SetTag("rpc.method", "ValidateBatch");
+        activity?.SetTag("batch_size", request.Requests.Count);
+
+        var stopwatch = Stopwatch.StartNew();
+        _logger.LogInformation("ValidateBatch called - items: {Count}, caller: {Caller}",
+            request.Requests.Count, request.Metadata?.CallerService);
+
+        // One validation delay (5-10ms) covers the whole batch
+        var delay = _random.Next(5, 11);
+        await Task.Delay(delay);
+
+        stopwatch.Stop();
+        var duration = stopwatch.Elapsed.TotalMilliseconds;
+
+        // Each item fails independently at the configured error rate
+        var response = new ValidationBatchResponse();
+        var failed = 0;
+        foreach (var item in request.Requests)
+        {
+            bool shouldFail = _random.NextDouble() < _errorRate;
+            _metrics.RecordRequest("ValidateBatch", shouldFail ? "error" : "ok");
+
+            if (shouldFail)
+            {
+                failed++;
+                response.Responses.Add(new ValidationResponse
+                {
+                    Status = new GrpcArchitecture.Proto.ResponseStatus
+                    {
+                        Success = false,
+                        Message = "Simulated validation error: Data failed validation checks"
+                    },
+                    IsValid = false
+                });
+            }
+            else
+            {
+                response.Responses.Add(new ValidationResponse
+                {
+                    Status = new GrpcArchitecture.Proto.ResponseStatus
+                    {
+                        Success = true,
+                        Message = "Validation successful"
+                    },
+                    IsValid = true
+                });
+            }
+        }
+        _metrics.RecordLatency("ValidateBatch", duration);
+
+        if (failed > 0)
+        {
+            activity?.SetTag("failed_items", failed);
+        }
+        activity?.SetTag("duration_ms", duration);
+
+        _logger.LogInformation("Batch validated - items: {Count}, failed: {Failed} (duration: {Duration}ms)",
+            request.Requests.Count, failed, duration);
+
+        return response;
+    }
+
     public class ErrorRateConfig
     {
         public double Value { get; }
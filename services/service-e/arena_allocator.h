@@ -0,0 +1,102 @@
+// Arena-backed message allocation for callback RPCs
+//
+// ArenaMessageAllocator places each call's request and response on a
+// google::protobuf::Arena whose first block lives inside a pooled holder.
+// Released holders are reset and reused, so a steady stream of small calls
+// allocates nothing, and large calls free their overflow blocks in one go.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <google/protobuf/arena.h>
+#include <grpcpp/support/message_allocator.h>
+
+// Arena with an inline initial block; embed it in a per-call object
+template <size_t kInitialBlockSize>
+class InlineArena {
+public:
+    InlineArena() : arena_(Options(block_)) {}
+
+    InlineArena(const InlineArena&) = delete;
+    InlineArena& operator=(const InlineArena&) = delete;
+
+    google::protobuf::Arena* get() { return &arena_; }
+
+    // Frees overflow blocks and rewinds the inline one
+    void Reset() { arena_.Reset(); }
+
+private:
+    static google::protobuf::ArenaOptions Options(char* block) {
+        google::protobuf::ArenaOptions options;
+        options.initial_block = block;
+        options.initial_block_size = kInitialBlockSize;
+        return options;
+    }
+
+    // Declared before arena_ so it outlives it
+    alignas(std::max_align_t) char block_[kInitialBlockSize];
+    google::protobuf::Arena arena_;
+};
+
+template <typename Request, typename Response, size_t kInitialBlockSize = 8192>
+class ArenaMessageAllocator final : public grpc::MessageAllocator<Request, Response> {
+public:
+    explicit ArenaMessageAllocator(size_t max_pooled = 256) : max_pooled_(max_pooled) {}
+
+    ~ArenaMessageAllocator() override {
+        for (Holder* holder : pool_) delete holder;
+    }
+
+    grpc::MessageHolder<Request, Response>* AllocateMessages() override {
+        Holder* holder = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!pool_.empty()) {
+                holder = pool_.back();
+                pool_.pop_back();
+            }
+        }
+        if (!holder) holder = new Holder(this);
+        holder->Allocate();
+        return holder;
+    }
+
+private:
+    class Holder final : public grpc::MessageHolder<Request, Response> {
+    public:
+        explicit Holder(ArenaMessageAllocator* owner) : owner_(owner) {}
+
+        void Allocate() {
+            this->set_request(google::protobuf::Arena::CreateMessage<Request>(arena_.get()));
+            this->set_response(google::protobuf::Arena::CreateMessage<Response>(arena_.get()));
+        }
+
+        void Release() override {
+            arena_.Reset();
+            owner_->Recycle(this);
+        }
+
+    private:
+        ArenaMessageAllocator* owner_;
+        InlineArena<kInitialBlockSize> arena_;
+    };
+
+    void Recycle(Holder* holder) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (pool_.size() < max_pooled_) {
+                pool_.push_back(holder);
+                return;
+            }
+        }
+        delete holder;
+    }
+
+    const size_t max_pooled_;
+    std::mutex mutex_;
+    std::vector<Holder*> pool_;
+};
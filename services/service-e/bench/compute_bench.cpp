@@ -0,0 +1,139 @@
+// Microbenchmarks for the Compute hot path: the numeric kernels, the
+// compute pool, and ComputeRequest/ComputeResponse wire handling
+//
+// Build with -DSERVICE_E_BUILD_BENCHMARKS=ON (or `make bench`) and compare
+// runs with Google Benchmark's compare.py to catch regressions.
+
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <google/protobuf/arena.h>
+
+#include "services.pb.h"
+#include "compute_kernels.h"
+#include "compute_pool.h"
+
+namespace {
+
+std::vector<double> RandomValues(size_t n) {
+    std::mt19937_64 gen(42);
+    std::uniform_real_distribution<double> dist(-1000.0, 1000.0);
+    std::vector<double> values(n);
+    for (auto& v : values) v = dist(gen);
+    return values;
+}
+
+ComputePool& SharedPool() {
+    static ComputePool pool{ComputePoolOptions{}};
+    return pool;
+}
+
+std::string SerializedRequest(size_t n) {
+    grpcarch::ComputeRequest request;
+    request.set_operation("transform");
+    request.mutable_metadata()->set_request_id("bench-request");
+    request.mutable_metadata()->set_caller_service("bench");
+    for (double v : RandomValues(n)) request.add_input_values(v);
+    return request.SerializeAsString();
+}
+
+void SetThroughput(benchmark::State& state, size_t values) {
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * values));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * values * sizeof(double)));
+}
+
+}  // namespace
+
+static void BM_KernelSum(benchmark::State& state) {
+    const auto n = static_cast<size_t>(state.range(0));
+    const auto input = RandomValues(n);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kernels::Sum(input.data(), n));
+    }
+    state.SetLabel(kernels::ActiveIsa());
+    SetThroughput(state, n);
+}
+BENCHMARK(BM_KernelSum)->RangeMultiplier(16)->Range(16, 1 << 20);
+
+static void BM_KernelTransform(benchmark::State& state) {
+    const auto n = static_cast<size_t>(state.range(0));
+    const auto input = RandomValues(n);
+    std::vector<double> output(n);
+    for (auto _ : state) {
+        kernels::Transform(input.data(), output.data(), n, 2.0, 1.0);
+        benchmark::ClobberMemory();
+    }
+    state.SetLabel(kernels::ActiveIsa());
+    SetThroughput(state, n);
+}
+BENCHMARK(BM_KernelTransform)->RangeMultiplier(16)->Range(16, 1 << 20);
+
+// Covers the switch to parallel mode at the pool's threshold
+static void BM_PoolSum(benchmark::State& state) {
+    const auto n = static_cast<size_t>(state.range(0));
+    const auto input = RandomValues(n);
+    auto& pool = SharedPool();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(pool.Sum(input.data(), n));
+    }
+    SetThroughput(state, n);
+}
+BENCHMARK(BM_PoolSum)->RangeMultiplier(4)->Range(1 << 16, 1 << 22)->UseRealTime();
+
+static void BM_PoolTransform(benchmark::State& state) {
+    const auto n = static_cast<size_t>(state.range(0));
+    const auto input = RandomValues(n);
+    std::vector<double> output(n);
+    auto& pool = SharedPool();
+    for (auto _ : state) {
+        pool.Transform(input.data(), output.data(), n, 2.0, 1.0);
+        benchmark::ClobberMemory();
+    }
+    SetThroughput(state, n);
+}
+BENCHMARK(BM_PoolTransform)->RangeMultiplier(4)->Range(1 << 16, 1 << 22)->UseRealTime();
+
+// Request parsing onto a per-call arena, as the server's message allocator does
+static void BM_ComputeRequestParse(benchmark::State& state) {
+    const auto n = static_cast<size_t>(state.range(0));
+    const std::string wire = SerializedRequest(n);
+    for (auto _ : state) {
+        google::protobuf::Arena arena;
+        auto* request = google::protobuf::Arena::CreateMessage<grpcarch::ComputeRequest>(&arena);
+        benchmark::DoNotOptimize(request->ParseFromString(wire));
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * n));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * wire.size()));
+}
+BENCHMARK(BM_ComputeRequestParse)->RangeMultiplier(16)->Range(16, 1 << 16);
+
+// Response building and serialization the way ComputeReactor fills it in
+static void BM_ComputeResponseSerialize(benchmark::State& state) {
+    const auto n = static_cast<size_t>(state.range(0));
+    const auto values = RandomValues(n);
+    std::string wire;
+    for (auto _ : state) {
+        google::protobuf::Arena arena;
+        auto* response = google::protobuf::Arena::CreateMessage<grpcarch::ComputeResponse>(&arena);
+        auto* output = response->mutable_output_values();
+        output->Reserve(static_cast<int>(n));
+        double* out = output->AddNAlreadyReserved(static_cast<int>(n));
+        kernels::Transform(values.data(), out, n, 2.0, 1.0);
+
+        response->mutable_status()->set_success(true);
+        response->mutable_status()->set_message("Computation and validation successful");
+        response->mutable_metrics()->set_operations_performed(static_cast<int32_t>(n));
+
+        wire.clear();
+        response->SerializeToString(&wire);
+        benchmark::DoNotOptimize(wire.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * n));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * wire.size()));
+}
+BENCHMARK(BM_ComputeResponseSerialize)->RangeMultiplier(16)->Range(16, 1 << 16);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,26 @@
+#include "channel_pool.h"
+
+ChannelPool::ChannelPool(const std::string& target, const ChannelPoolOptions& options) {
+    const size_t count = options.channels > 0 ? options.channels : 1;
+
+    for (size_t i = 0; i < count; i++) {
+        grpc::ChannelArguments args;
+        // Channels with identical args would share one subchannel, and with it one connection
+        args.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+        args.SetInt("service_e.channel_index", static_cast<int>(i));
+
+        if (!options.lb_policy.empty()) args.SetLoadBalancingPolicyName(options.lb_policy);
+
+        args.SetInt(GRPC_ARG_KEEPALIVE_TIME_MS, options.keepalive_time_ms);
+        args.SetInt(GRPC_ARG_KEEPALIVE_TIMEOUT_MS, options.keepalive_timeout_ms);
+        args.SetInt(GRPC_ARG_KEEPALIVE_PERMIT_WITHOUT_CALLS, 1);
+        args.SetInt(GRPC_ARG_HTTP2_MAX_PINGS_WITHOUT_DATA, 0);
+
+        auto channel = grpc::CreateCustomChannel(target, grpc::InsecureChannelCredentials(), args);
+        // Start connecting now so the first calls don't pay for the handshake
+        channel->GetState(true);
+
+        stubs_.push_back(grpcarch::ServiceD::NewStub(channel));
+        channels_.push_back(std::move(channel));
+    }
+}
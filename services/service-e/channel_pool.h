@@ -0,0 +1,49 @@
+// Pool of channels from service-e to ServiceD
+//
+// Every channel gets a distinct channel argument and a local subchannel
+// pool, so each one opens its own HTTP/2 connection instead of sharing a
+// subchannel. Calls take stubs round-robin across the pool, spreading
+// streams over connections and flow-control windows. With the round_robin
+// load-balancing policy and a dns:/// target, each channel also balances
+// across every resolved ServiceD replica. Keepalive pings keep idle
+// connections warm.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <grpcpp/grpcpp.h>
+
+#include "services.grpc.pb.h"
+
+struct ChannelPoolOptions {
+    size_t channels = 4;               // Connections to open; 0 is treated as 1
+    std::string lb_policy;             // e.g. "round_robin"; empty keeps gRPC's default (pick_first)
+    int keepalive_time_ms = 30000;     // Idle time before a keepalive ping
+    int keepalive_timeout_ms = 10000;  // Wait for the ping ack before dropping the connection
+};
+
+class ChannelPool {
+public:
+    ChannelPool(const std::string& target, const ChannelPoolOptions& options);
+
+    ChannelPool(const ChannelPool&) = delete;
+    ChannelPool& operator=(const ChannelPool&) = delete;
+
+    // Stub for the next channel in round-robin order; valid for the pool's lifetime
+    grpcarch::ServiceD::Stub* Next() {
+        size_t i = next_.fetch_add(1, std::memory_order_relaxed);
+        return stubs_[i % stubs_.size()].get();
+    }
+
+    size_t size() const { return stubs_.size(); }
+
+private:
+    std::vector<std::shared_ptr<grpc::Channel>> channels_;
+    std::vector<std::unique_ptr<grpcarch::ServiceD::Stub>> stubs_;
+    std::atomic<size_t> next_{0};
+};
@@ -0,0 +1,206 @@
+#include "compute_kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KERNELS_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define KERNELS_NEON 1
+#endif
+
+namespace kernels {
+namespace {
+
+double SumScalar(const double* data, size_t n) {
+    CompensatedSum acc;
+    for (size_t i = 0; i < n; i++) {
+        acc.Add(data[i]);
+    }
+    return acc.Result();
+}
+
+void TransformScalar(const double* in, double* out, size_t n, double scale, double offset) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = in[i] * scale + offset;
+    }
+}
+
+// Fold per-lane Kahan sums and compensations, then the scalar tail
+[[maybe_unused]] double FoldLanes(const double* sums, const double* compensations,
+                                  size_t lanes, const double* tail, size_t tail_count) {
+    CompensatedSum acc;
+    for (size_t i = 0; i < lanes; i++) {
+        acc.Add(sums[i]);
+        acc.Add(-compensations[i]);
+    }
+    for (size_t i = 0; i < tail_count; i++) {
+        acc.Add(tail[i]);
+    }
+    return acc.Result();
+}
+
+#if defined(KERNELS_X86)
+
+__attribute__((target("avx2")))
+double SumAvx2(const double* data, size_t n) {
+    // Two independent accumulators hide the add latency
+    __m256d s0 = _mm256_setzero_pd(), c0 = _mm256_setzero_pd();
+    __m256d s1 = _mm256_setzero_pd(), c1 = _mm256_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256d y0 = _mm256_sub_pd(_mm256_loadu_pd(data + i), c0);
+        __m256d y1 = _mm256_sub_pd(_mm256_loadu_pd(data + i + 4), c1);
+        __m256d t0 = _mm256_add_pd(s0, y0);
+        __m256d t1 = _mm256_add_pd(s1, y1);
+        c0 = _mm256_sub_pd(_mm256_sub_pd(t0, s0), y0);
+        c1 = _mm256_sub_pd(_mm256_sub_pd(t1, s1), y1);
+        s0 = t0;
+        s1 = t1;
+    }
+
+    alignas(32) double sums[8];
+    alignas(32) double compensations[8];
+    _mm256_store_pd(sums, s0);
+    _mm256_store_pd(sums + 4, s1);
+    _mm256_store_pd(compensations, c0);
+    _mm256_store_pd(compensations + 4, c1);
+    return FoldLanes(sums, compensations, 8, data + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void TransformAvx2(const double* in, double* out, size_t n, double scale, double offset) {
+    __m256d vscale = _mm256_set1_pd(scale);
+    __m256d voffset = _mm256_set1_pd(offset);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d v = _mm256_loadu_pd(in + i);
+        _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_mul_pd(v, vscale), voffset));
+    }
+    TransformScalar(in + i, out + i, n - i, scale, offset);
+}
+
+__attribute__((target("avx512f")))
+double SumAvx512(const double* data, size_t n) {
+    __m512d s0 = _mm512_setzero_pd(), c0 = _mm512_setzero_pd();
+    __m512d s1 = _mm512_setzero_pd(), c1 = _mm512_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512d y0 = _mm512_sub_pd(_mm512_loadu_pd(data + i), c0);
+        __m512d y1 = _mm512_sub_pd(_mm512_loadu_pd(data + i + 8), c1);
+        __m512d t0 = _mm512_add_pd(s0, y0);
+        __m512d t1 = _mm512_add_pd(s1, y1);
+        c0 = _mm512_sub_pd(_mm512_sub_pd(t0, s0), y0);
+        c1 = _mm512_sub_pd(_mm512_sub_pd(t1, s1), y1);
+        s0 = t0;
+        s1 = t1;
+    }
+
+    alignas(64) double sums[16];
+    alignas(64) double compensations[16];
+    _mm512_store_pd(sums, s0);
+    _mm512_store_pd(sums + 8, s1);
+    _mm512_store_pd(compensations, c0);
+    _mm512_store_pd(compensations + 8, c1);
+    return FoldLanes(sums, compensations, 16, data + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+void TransformAvx512(const double* in, double* out, size_t n, double scale, double offset) {
+    __m512d vscale = _mm512_set1_pd(scale);
+    __m512d voffset = _mm512_set1_pd(offset);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d v = _mm512_loadu_pd(in + i);
+        _mm512_storeu_pd(out + i, _mm512_add_pd(_mm512_mul_pd(v, vscale), voffset));
+    }
+    TransformScalar(in + i, out + i, n - i, scale, offset);
+}
+
+#elif defined(KERNELS_NEON)
+
+double SumNeon(const double* data, size_t n) {
+    float64x2_t s0 = vdupq_n_f64(0.0), c0 = vdupq_n_f64(0.0);
+    float64x2_t s1 = vdupq_n_f64(0.0), c1 = vdupq_n_f64(0.0);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        float64x2_t y0 = vsubq_f64(vld1q_f64(data + i), c0);
+        float64x2_t y1 = vsubq_f64(vld1q_f64(data + i + 2), c1);
+        float64x2_t t0 = vaddq_f64(s0, y0);
+        float64x2_t t1 = vaddq_f64(s1, y1);
+        c0 = vsubq_f64(vsubq_f64(t0, s0), y0);
+        c1 = vsubq_f64(vsubq_f64(t1, s1), y1);
+        s0 = t0;
+        s1 = t1;
+    }
+
+    double sums[4];
+    double compensations[4];
+    vst1q_f64(sums, s0);
+    vst1q_f64(sums + 2, s1);
+    vst1q_f64(compensations, c0);
+    vst1q_f64(compensations + 2, c1);
+    return FoldLanes(sums, compensations, 4, data + i, n - i);
+}
+
+void TransformNeon(const double* in, double* out, size_t n, double scale, double offset) {
+    float64x2_t vscale = vdupq_n_f64(scale);
+    float64x2_t voffset = vdupq_n_f64(offset);
+
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        float64x2_t v = vld1q_f64(in + i);
+        vst1q_f64(out + i, vaddq_f64(vmulq_f64(v, vscale), voffset));
+    }
+    TransformScalar(in + i, out + i, n - i, scale, offset);
+}
+
+#endif
+
+// Function table chosen once from the CPU's feature flags
+struct KernelTable {
+    double (*sum)(const double*, size_t);
+    void (*transform)(const double*, double*, size_t, double, double);
+    const char* isa;
+};
+
+KernelTable SelectKernels() {
+#if defined(KERNELS_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return {SumAvx512, TransformAvx512, "avx512"};
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return {SumAvx2, TransformAvx2, "avx2"};
+    }
+#elif defined(KERNELS_NEON)
+    // Advanced SIMD is mandatory on AArch64
+    return {SumNeon, TransformNeon, "neon"};
+#endif
+    return {SumScalar, TransformScalar, "scalar"};
+}
+
+const KernelTable& Kernels() {
+    static const KernelTable table = SelectKernels();
+    return table;
+}
+
+}  // namespace
+
+double Sum(const double* data, size_t n) {
+    return Kernels().sum(data, n);
+}
+
+void Transform(const double* in, double* out, size_t n, double scale, double offset) {
+    Kernels().transform(in, out, n, scale, offset);
+}
+
+const char* ActiveIsa() {
+    return Kernels().isa;
+}
+
+}  // namespace kernels
@@ -0,0 +1,41 @@
+// Vectorized numeric kernels for Compute
+//
+// Each kernel has scalar, AVX2, AVX-512 and NEON variants; the widest one
+// the CPU supports is picked once, on first use. Summation is
+// Kahan-compensated per SIMD lane so large inputs keep full precision.
+
+#pragma once
+
+#include <cstddef>
+
+namespace kernels {
+
+// Neumaier's variant of Kahan summation; also correct when the addend
+// is larger in magnitude than the running sum
+struct CompensatedSum {
+    double sum = 0.0;
+    double compensation = 0.0;
+
+    void Add(double value) {
+        double t = sum + value;
+        if ((sum >= 0 ? sum : -sum) >= (value >= 0 ? value : -value)) {
+            compensation += (sum - t) + value;
+        } else {
+            compensation += (value - t) + sum;
+        }
+        sum = t;
+    }
+
+    double Result() const { return sum + compensation; }
+};
+
+// Compensated sum of n doubles
+double Sum(const double* data, size_t n);
+
+// out[i] = in[i] * scale + offset; in and out may alias exactly
+void Transform(const double* in, double* out, size_t n, double scale, double offset);
+
+// Name of the instruction set selected at runtime ("avx512", "avx2", "neon", "scalar")
+const char* ActiveIsa();
+
+}  // namespace kernels
@@ -0,0 +1,118 @@
+#include "compute_pool.h"
+
+#include <algorithm>
+
+#include "compute_kernels.h"
+
+// One ParallelFor call; shared so a worker may finish with it after the caller returns
+struct ComputePool::Job {
+    const std::function<void(size_t)>* body;
+    size_t count;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> completed{0};
+
+    std::mutex mutex;
+    std::condition_variable done;
+};
+
+ComputePool::ComputePool(const ComputePoolOptions& options) : options_(options) {
+    if (options_.chunk_size == 0) options_.chunk_size = ComputePoolOptions{}.chunk_size;
+
+    size_t threads = options_.threads;
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // The calling thread is the last participant
+    for (size_t i = 1; i < threads; i++) {
+        workers_.emplace_back([this] { WorkerLoop(); });
+    }
+}
+
+ComputePool::~ComputePool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    work_available_.notify_all();
+    for (auto& worker : workers_) worker.join();
+}
+
+double ComputePool::Sum(const double* data, size_t n) {
+    if (workers_.empty() || n < options_.parallel_threshold) {
+        return kernels::Sum(data, n);
+    }
+
+    const size_t chunk = options_.chunk_size;
+    const size_t chunks = (n + chunk - 1) / chunk;
+    std::vector<double> partials(chunks);
+
+    ParallelFor(chunks, [&](size_t i) {
+        size_t begin = i * chunk;
+        partials[i] = kernels::Sum(data + begin, std::min(chunk, n - begin));
+    });
+
+    return kernels::Sum(partials.data(), partials.size());
+}
+
+void ComputePool::Transform(const double* in, double* out, size_t n, double scale, double offset) {
+    if (workers_.empty() || n < options_.parallel_threshold) {
+        kernels::Transform(in, out, n, scale, offset);
+        return;
+    }
+
+    const size_t chunk = options_.chunk_size;
+    const size_t chunks = (n + chunk - 1) / chunk;
+
+    ParallelFor(chunks, [&](size_t i) {
+        size_t begin = i * chunk;
+        kernels::Transform(in + begin, out + begin, std::min(chunk, n - begin), scale, offset);
+    });
+}
+
+void ComputePool::RunChunks(Job& job) {
+    size_t i;
+    while ((i = job.next.fetch_add(1, std::memory_order_relaxed)) < job.count) {
+        (*job.body)(i);
+        if (job.completed.fetch_add(1, std::memory_order_acq_rel) + 1 == job.count) {
+            std::lock_guard<std::mutex> lock(job.mutex);
+            job.done.notify_all();
+        }
+    }
+}
+
+void ComputePool::ParallelFor(size_t count, const std::function<void(size_t)>& body) {
+    auto job = std::make_shared<Job>();
+    job->body = &body;
+    job->count = count;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.push_back(job);
+    }
+    work_available_.notify_all();
+
+    RunChunks(*job);
+
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->done.wait(lock, [&] {
+        return job->completed.load(std::memory_order_acquire) == job->count;
+    });
+}
+
+void ComputePool::WorkerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        work_available_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+        if (stopping_) return;
+
+        std::shared_ptr<Job> job = jobs_.front();
+        if (job->next.load(std::memory_order_relaxed) >= job->count) {
+            // Every chunk has been claimed; retire it and look at the next job
+            jobs_.pop_front();
+            continue;
+        }
+
+        lock.unlock();
+        RunChunks(*job);
+        lock.lock();
+    }
+}
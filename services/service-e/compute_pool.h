@@ -0,0 +1,57 @@
+// Parallel execution of compute kernels over large inputs
+//
+// Inputs at or above the parallel threshold are split into cache-sized
+// chunks that a fixed pool of worker threads claims dynamically; the
+// calling thread claims chunks too, so a busy pool never stalls a call.
+// Smaller inputs run the kernel inline.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct ComputePoolOptions {
+    size_t threads = 0;                 // Worker threads; 0 = hardware concurrency
+    size_t parallel_threshold = 262144; // Minimum element count for parallel mode
+    size_t chunk_size = 32768;          // Elements per chunk (256 KB of doubles)
+};
+
+class ComputePool {
+public:
+    explicit ComputePool(const ComputePoolOptions& options);
+    ~ComputePool();
+
+    ComputePool(const ComputePool&) = delete;
+    ComputePool& operator=(const ComputePool&) = delete;
+
+    // Compensated sum; chunk partials are combined with compensation as well
+    double Sum(const double* data, size_t n);
+
+    // out[i] = in[i] * scale + offset, each chunk writing a disjoint range
+    void Transform(const double* in, double* out, size_t n, double scale, double offset);
+
+    size_t threads() const { return workers_.size() + 1; }
+
+private:
+    struct Job;
+
+    // Run body(0..count-1) across the pool and the calling thread; blocks until all are done
+    void ParallelFor(size_t count, const std::function<void(size_t)>& body);
+    void WorkerLoop();
+    static void RunChunks(Job& job);
+
+    ComputePoolOptions options_;
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable work_available_;
+    std::deque<std::shared_ptr<Job>> jobs_;
+    bool stopping_ = false;
+};
@@ -3,11 +3,17 @@
 #include <string>
 #include <random>
 #include <thread>
+#include <cctype>
 #include <chrono>
 #include <cstdlib>
-#include <numeric>
+#include <vector>
+#include <string_view>
+#include <type_traits>
+#include <atomic>
+#include <algorithm>
 
 #include <grpcpp/grpcpp.h>
+#include <grpcpp/alarm.h>
 #include <grpcpp/health_check_service_interface.h>
 
 #include "opentelemetry/exporters/otlp/otlp_grpc_exporter_factory.h"
@@ -17,14 +23,21 @@
 #include "opentelemetry/sdk/trace/batch_span_processor_factory.h"
 #include "opentelemetry/sdk/trace/batch_span_processor_options.h"
 #include "opentelemetry/sdk/trace/tracer_provider_factory.h"
+#include "opentelemetry/sdk/trace/samplers/parent_factory.h"
+#include "opentelemetry/sdk/trace/samplers/trace_id_ratio_factory.h"
 #include "opentelemetry/sdk/metrics/meter_provider_factory.h"
 #include "opentelemetry/sdk/metrics/meter_provider.h"
 #include "opentelemetry/sdk/metrics/meter_context_factory.h"
 #include "opentelemetry/sdk/metrics/export/periodic_exporting_metric_reader_factory.h"
+#include "opentelemetry/sdk/metrics/aggregation/aggregation_config.h"
+#include "opentelemetry/sdk/metrics/view/instrument_selector_factory.h"
+#include "opentelemetry/sdk/metrics/view/meter_selector_factory.h"
+#include "opentelemetry/sdk/metrics/view/view_factory.h"
 #include "opentelemetry/sdk/logs/logger_provider_factory.h"
 #include "opentelemetry/sdk/logs/processor.h"
 #include "opentelemetry/sdk/logs/batch_log_record_processor_factory.h"
 #include "opentelemetry/sdk/logs/batch_log_record_processor_options.h"
+#include "opentelemetry/trace/context.h"
 #include "opentelemetry/trace/provider.h"
 #include "opentelemetry/metrics/provider.h"
 #include "opentelemetry/logs/provider.h"
@@ -34,6 +47,16 @@
 #include "opentelemetry/trace/propagation/http_trace_context.h"
 
 #include "services.grpc.pb.h"
+#include "compute_kernels.h"
+#include "arena_allocator.h"
+#include "compute_pool.h"
+#include "channel_pool.h"
+#include "validation_batcher.h"
+#include "result_cache.h"
+#include "tail_sampling.h"
+#include "stage_timer.h"
+#include "metric_attributes.h"
+#include "trace_propagation.h"
 
 namespace trace_api = opentelemetry::trace;
 namespace metrics_api = opentelemetry::metrics;
@@ -44,10 +67,99 @@ namespace trace_sdk = opentelemetry::sdk::trace;
 namespace metrics_sdk = opentelemetry::sdk::metrics;
 namespace logs_sdk = opentelemetry::sdk::logs;
 
-class ServiceEImpl final : public grpcarch::ServiceE::Service {
+// Compute operations, resolved once per request instead of string compares
+enum class Operation { kSum, kAverage, kTransform, kEcho };
+
+Operation ParseOperation(std::string_view name) {
+    static constexpr std::pair<std::string_view, Operation> kOperations[] = {
+        {"sum", Operation::kSum},
+        {"average", Operation::kAverage},
+        {"transform", Operation::kTransform},
+    };
+    for (const auto& [key, op] : kOperations) {
+        if (key == name) return op;
+    }
+    // Default: echo values
+    return Operation::kEcho;
+}
+
+// Minimum severity that reaches the logger (SERVICE_E_LOG_LEVEL, default: info)
+logs_api::Severity MinLogSeverity() {
+    const char* level_env = std::getenv("SERVICE_E_LOG_LEVEL");
+    std::string_view level = level_env ? level_env : "info";
+    if (level == "debug") return logs_api::Severity::kDebug;
+    if (level == "warn") return logs_api::Severity::kWarn;
+    if (level == "error") return logs_api::Severity::kError;
+    return logs_api::Severity::kInfo;
+}
+
+// Read a non-negative integer from the environment
+size_t EnvSize(const char* name, size_t default_value) {
+    const char* value = std::getenv(name);
+    if (!value || !*value) return default_value;
+    char* end = nullptr;
+    unsigned long long parsed = std::strtoull(value, &end, 10);
+    if (*end != '\0') {
+        std::cerr << "[Service E] Ignoring invalid " << name << "=" << value << std::endl;
+        return default_value;
+    }
+    return static_cast<size_t>(parsed);
+}
+
+// Read a non-negative number from the environment
+double EnvDouble(const char* name, double default_value) {
+    const char* value = std::getenv(name);
+    if (!value || !*value) return default_value;
+    char* end = nullptr;
+    double parsed = std::strtod(value, &end);
+    if (*end != '\0' || parsed < 0.0) {
+        std::cerr << "[Service E] Ignoring invalid " << name << "=" << value << std::endl;
+        return default_value;
+    }
+    return parsed;
+}
+
+std::string Lowercase(std::string value) {
+    for (auto& c : value) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return value;
+}
+
+// OTLP exporter compression for one signal: OTEL_EXPORTER_OTLP_<SIGNAL>_COMPRESSION,
+// else OTEL_EXPORTER_OTLP_COMPRESSION. The gRPC exporters only implement
+// gzip, so "zstd" falls back to it.
+std::string OtlpCompression(const char* signal_env) {
+    const char* value = std::getenv(signal_env);
+    if (!value || !*value) value = std::getenv("OTEL_EXPORTER_OTLP_COMPRESSION");
+    if (!value || !*value) return "none";
+
+    std::string compression = Lowercase(value);
+    if (compression == "gzip" || compression == "none") return compression;
+    if (compression == "zstd") {
+        std::cerr << "[Service E] zstd OTLP compression is not supported, using gzip" << std::endl;
+        return "gzip";
+    }
+    std::cerr << "[Service E] Ignoring unknown OTLP compression " << value << std::endl;
+    return "none";
+}
+
+// Deadline handling, load shedding and response compression for incoming calls
+struct ServingOptions {
+    size_t max_in_flight = 1024;                     // Calls admitted at once; 0 = unbounded
+    std::chrono::milliseconds deadline_margin{2};    // Held back from the ServiceD subcall's deadline
+    std::chrono::milliseconds compute_cost{20};      // Budget a call needs to be worth starting
+    size_t compression_min_bytes = 0;                // Compress responses at least this large; 0 = off
+};
+
+class ServiceEImpl final : public grpcarch::ServiceE::CallbackService {
 public:
-    ServiceEImpl(const std::string& service_d_addr)
-        : service_d_addr_(service_d_addr) {
+    ServiceEImpl(const std::string& service_d_addr, ComputePool* compute_pool,
+                 const ChannelPoolOptions& channel_opts,
+                 const ValidationBatcherOptions& batcher_opts,
+                 const ResultCacheOptions& cache_opts,
+                 const ServingOptions& serving_opts)
+        : service_d_addr_(service_d_addr), compute_pool_(compute_pool),
+          result_cache_(cache_opts), serving_opts_(serving_opts),
+          min_log_severity_(MinLogSeverity()) {
         auto provider = trace_api::Provider::GetTracerProvider();
         tracer_ = provider->GetTracer("service-e", "1.0.0");
 
@@ -55,150 +167,599 @@ public:
         auto meter = meter_provider->GetMeter("service-e", "1.0.0");
         request_counter_ = meter->CreateUInt64Counter("service_e_requests_total");
         latency_histogram_ = meter->CreateDoubleHistogram("service_e_request_duration_ms");
+        stage_histogram_ = meter->CreateDoubleHistogram("service_e_stage_duration_ms",
+            "Time spent in each stage of a call", "ms");
+        cache_hit_counter_ = meter->CreateUInt64Counter("service_e_cache_hits_total");
+        cache_miss_counter_ = meter->CreateUInt64Counter("service_e_cache_misses_total");
 
         auto logger_provider = logs_api::Provider::GetLoggerProvider();
         logger_ = logger_provider->GetLogger("service-e", "1.0.0");
 
-        // Create gRPC channel to Service D
-        service_d_stub_ = grpcarch::ServiceD::NewStub(
-            grpc::CreateChannel(service_d_addr, grpc::InsecureChannelCredentials()));
+        // Create a pool of gRPC channels to Service D
+        service_d_channels_ = std::make_unique<ChannelPool>(service_d_addr, channel_opts);
+
+        // Validations from concurrent calls share ValidateBatch round trips
+        validation_batcher_ = std::make_unique<ValidationBatcher>(service_d_channels_.get(), batcher_opts);
     }
 
-    grpc::Status Compute(
-        grpc::ServerContext* context,
+    grpc::ServerUnaryReactor* Compute(
+        grpc::CallbackServerContext* context,
         const grpcarch::ComputeRequest* request,
         grpcarch::ComputeResponse* response) override {
+        StageTimer timer;
+        if (result_cache_.enabled()) {
+            if (ServeFromCache(context, request, response, timer)) {
+                MaybeCompress(context, *response);
+                auto* reactor = context->DefaultReactor();
+                reactor->Finish(grpc::Status::OK);
+                return reactor;
+            }
+            timer.End(Stage::kCache);
+            cache_miss_counter_->Add(1, compute_attrs_.Method(), no_context_);
+        }
 
-        auto start = std::chrono::high_resolution_clock::now();
+        // Shed calls that cannot finish in time before spending anything on them
+        grpc::Status rejection = CheckBudget(compute_attrs_, context, serving_opts_.compute_cost);
+        if (rejection.ok()) rejection = Admit(compute_attrs_);
+        if (!rejection.ok()) {
+            auto* reactor = context->DefaultReactor();
+            reactor->Finish(rejection);
+            return reactor;
+        }
 
-        trace_api::StartSpanOptions span_opts;
-        auto span = tracer_->StartSpan("Compute",
-            {{"rpc.system", "grpc"},
-             {"rpc.service", "ServiceE"},
-             {"rpc.method", "Compute"}},
-            span_opts);
-        auto scope = tracer_->WithActiveSpan(span);
+        // The reactor owns the call from here on; no server thread waits on it
+        return new ComputeReactor(this, context, request, response, timer);
+    }
+
+    grpc::ServerBidiReactor<grpcarch::ComputeStreamRequest, grpcarch::ComputeStreamResponse>*
+    ComputeStream(grpc::CallbackServerContext* context) override {
+        grpc::Status rejection = CheckBudget(stream_attrs_, context, serving_opts_.compute_cost);
+        if (rejection.ok()) rejection = Admit(stream_attrs_);
+        if (!rejection.ok()) return new RejectedStreamReactor(rejection);
+        return new ComputeStreamReactor(this, context);
+    }
+
+private:
+    // Rejects a call whose remaining deadline is shorter than the work it needs
+    grpc::Status CheckBudget(const MethodAttributes& method, grpc::CallbackServerContext* context,
+                             std::chrono::milliseconds cost) {
+        auto deadline = context->deadline();
+        if (deadline == std::chrono::system_clock::time_point::max()) return grpc::Status::OK;
+
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::system_clock::now());
+        if (remaining >= cost) return grpc::Status::OK;
+
+        request_counter_->Add(1, method.Status(CallStatus::kDeadlineExceeded), no_context_);
+        LogWarn([&] {
+            return std::string(method.name()) + " rejected: " + std::to_string(remaining.count()) +
+                   "ms left, " + std::to_string(cost.count()) + "ms needed";
+        });
+        return grpc::Status(grpc::StatusCode::DEADLINE_EXCEEDED,
+                            "Remaining deadline is shorter than the expected compute time");
+    }
+
+    // Bounds the number of calls in progress; an admitted call is released in its reactor's OnDone
+    grpc::Status Admit(const MethodAttributes& method) {
+        if (serving_opts_.max_in_flight == 0) return grpc::Status::OK;
+        if (in_flight_.fetch_add(1, std::memory_order_relaxed) < serving_opts_.max_in_flight) {
+            return grpc::Status::OK;
+        }
+        in_flight_.fetch_sub(1, std::memory_order_relaxed);
+
+        request_counter_->Add(1, method.Status(CallStatus::kOverloaded), no_context_);
+        LogWarn([&] { return std::string(method.name()) + " rejected: server overloaded"; });
+        return grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED, "Too many calls in progress");
+    }
+
+    void Release() {
+        if (serving_opts_.max_in_flight != 0) in_flight_.fetch_sub(1, std::memory_order_relaxed);
+    }
 
+    bool CompressionEnabled() const { return serving_opts_.compression_min_bytes != 0; }
+
+    bool ShouldCompress(const google::protobuf::Message& message) const {
+        return CompressionEnabled() && message.ByteSizeLong() >= serving_opts_.compression_min_bytes;
+    }
+
+    // Compresses a large unary response; must run before the response is sent
+    void MaybeCompress(grpc::CallbackServerContext* context, const google::protobuf::Message& response) const {
+        if (ShouldCompress(response)) context->set_compression_level(GRPC_COMPRESS_LEVEL_LOW);
+    }
+
+    // Streams pick the call's codec up front, then skip it for small messages
+    grpc::WriteOptions StreamWriteOptions(const google::protobuf::Message& message) const {
+        grpc::WriteOptions options;
+        if (CompressionEnabled() && !ShouldCompress(message)) options.set_no_compression();
+        return options;
+    }
+
+    // ServiceD gets the caller's deadline less the margin, so an answer can
+    // still be sent back before the caller gives up
+    ValidationBatcher::Deadline SubcallDeadline(grpc::CallbackServerContext* context) const {
+        auto deadline = context->deadline();
+        if (deadline == std::chrono::system_clock::time_point::max()) return deadline;
+        return deadline - serving_opts_.deadline_margin;
+    }
+
+    // Ends a ComputeStream call refused by the budget check or admission control
+    class RejectedStreamReactor final
+        : public grpc::ServerBidiReactor<grpcarch::ComputeStreamRequest,
+                                         grpcarch::ComputeStreamResponse> {
+    public:
+        explicit RejectedStreamReactor(const grpc::Status& status) { Finish(status); }
+        void OnDone() override { delete this; }
+    };
+
+    // A repeated payload skips the compute delay, the kernels and the
+    // ServiceD round trip; only validated results are ever cached
+    bool ServeFromCache(grpc::CallbackServerContext* context, const grpcarch::ComputeRequest* request,
+                        grpcarch::ComputeResponse* response, StageTimer& timer) {
+        const auto& input = request->input_values();
+        const auto operation = static_cast<uint32_t>(ParseOperation(request->operation()));
+        if (!result_cache_.Lookup(operation, input.data(), static_cast<size_t>(input.size()),
+                                  response->mutable_output_values())) {
+            return false;
+        }
+
+        response->mutable_status()->set_success(true);
+        response->mutable_status()->set_message("Computation and validation successful (cached)");
+
+        timer.End(Stage::kCache);
+        double duration_ms = timer.TotalMilliseconds();
+
+        SetComputeMetrics(response->mutable_metrics(), duration_ms, response->output_values_size());
+
+        auto span = StartServerSpan(compute_attrs_, *context);
+        cache_hit_counter_->Add(1, compute_attrs_.Method(), ExemplarContext(span));
         span->SetAttribute("operation", request->operation());
         span->SetAttribute("input_count", static_cast<int>(request->input_values_size()));
+        span->SetAttribute("cache.hit", true);
+
+        LogInfo([&] {
+            return "Compute served from cache - operation: " + request->operation() +
+                   ", inputs: " + std::to_string(request->input_values_size());
+        });
+
+        RecordCall(compute_attrs_, span, CallStatus::kOk, duration_ms, timer);
+        return true;
+    }
+
+    using SpanPtr = opentelemetry::nostd::shared_ptr<trace_api::Span>;
 
-        LogInfo("Compute called - operation: " + request->operation() +
-                ", inputs: " + std::to_string(request->input_values_size()));
-
-        // Simulate computation (8-12ms)
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_int_distribution<> delay_dist(8, 12);
-        std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
-
-        // Perform computation based on operation
-        std::vector<double> results;
-        std::string operation = request->operation();
-
-        if (operation == "sum") {
-            double sum = std::accumulate(request->input_values().begin(),
-                                         request->input_values().end(), 0.0);
-            results.push_back(sum);
-        } else if (operation == "average") {
-            if (request->input_values_size() > 0) {
-                double sum = std::accumulate(request->input_values().begin(),
-                                             request->input_values().end(), 0.0);
-                results.push_back(sum / request->input_values_size());
+    // Measurements recorded with this context can carry the span's trace as an exemplar
+    static opentelemetry::context::Context ExemplarContext(const SpanPtr& span) {
+        opentelemetry::context::Context ctx;
+        return trace_api::SetSpan(ctx, span);
+    }
+
+    void RecordStages(const MethodAttributes& method, const StageTimer& timer,
+                      const opentelemetry::context::Context& ctx) {
+        for (size_t i = 0; i < kStageCount; i++) {
+            const auto stage = static_cast<Stage>(i);
+            if (!timer.Entered(stage)) continue;
+            stage_histogram_->Record(timer.Milliseconds(stage), method.ForStage(stage), ctx);
+        }
+    }
+
+    // Parented on the caller's span if it sent one
+    SpanPtr StartServerSpan(const MethodAttributes& method, const grpc::ServerContextBase& context) {
+        return tracer_->StartSpan(method.name(),
+            {{"rpc.system", "grpc"},
+             {"rpc.service", "ServiceE"},
+             {"rpc.method", method.name()}},
+            ServerSpanOptions(context));
+    }
+
+    // One call's ServiceD subcall. The request lives on a per-call arena
+    // whose first block is part of the reactor holding this.
+    struct Validation {
+        SpanPtr span;
+        InlineArena<4096> arena;
+        grpcarch::ValidationRequest* request = nullptr;
+    };
+
+    // Sends a call's results to Service D under a child span of parent
+    void StartValidation(Validation& validation, const SpanPtr& parent, ValidationBatcher::Deadline deadline,
+                         const char* id, std::string content, ValidationBatcher::Callback done) {
+        trace_api::StartSpanOptions validation_opts;
+        validation_opts.parent = parent->GetContext();
+        validation_opts.kind = trace_api::SpanKind::kClient;
+        validation.span = tracer_->StartSpan("CallServiceD", validation_opts);
+
+        validation.request = google::protobuf::Arena::CreateMessage<grpcarch::ValidationRequest>(
+            validation.arena.get());
+
+        validation.request->mutable_metadata()->set_caller_service("service-e");
+        validation.request->mutable_data()->set_id(id);
+        validation.request->mutable_data()->set_content(std::move(content));
+
+        LogInfo("Calling Service D for validation");
+        validation_batcher_->Validate(*validation.request, deadline, ExemplarContext(validation.span),
+                                      std::move(done));
+    }
+
+    // Ends the validation span and tells the client how validation went.
+    // A failed validation still returns our results.
+    void FinishValidation(Validation& validation, const grpc::Status& validation_status,
+                          grpcarch::ResponseStatus* status) {
+        if (!validation_status.ok()) {
+            validation.span->SetStatus(trace_api::StatusCode::kError, validation_status.error_message());
+            LogWarn([&] { return "Service D validation failed: " + validation_status.error_message(); });
+            status->set_success(false);
+            status->set_message("Computation complete but validation failed: " +
+                                validation_status.error_message());
+        } else {
+            validation.span->SetStatus(trace_api::StatusCode::kOk, "");
+            status->set_success(true);
+            status->set_message("Computation and validation successful");
+        }
+        validation.span->End();
+    }
+
+    static void SetComputeMetrics(grpcarch::ComputeMetrics* metrics, double duration_ms, int32_t operations) {
+        metrics->set_compute_time_ms(static_cast<int64_t>(duration_ms));
+        metrics->set_operations_performed(operations);
+        metrics->set_memory_used_mb(0.5);
+    }
+
+    // Records a finished call and ends its span. Method-specific span
+    // attributes and logs go in before this; it closes the telemetry stage.
+    void RecordCall(const MethodAttributes& method, const SpanPtr& span, CallStatus status,
+                    double duration_ms, StageTimer& timer) {
+        auto ctx = ExemplarContext(span);
+        request_counter_->Add(1, method.Status(status), ctx);
+        latency_histogram_->Record(duration_ms, method.Method(), ctx);
+
+        span->SetAttribute("duration_ms", duration_ms);
+        span->SetStatus(trace_api::StatusCode::kOk, "");
+        span->End();
+
+        timer.End(Stage::kTelemetry);
+        RecordStages(method, timer, ctx);
+    }
+
+    // State of one in-flight Compute call. Each step is a callback: the
+    // simulated compute delay is a grpc::Alarm and the ServiceD validation
+    // is an async stub call, so a call holds no thread while it waits.
+    class ComputeReactor final : public grpc::ServerUnaryReactor {
+    public:
+        ComputeReactor(ServiceEImpl* service,
+                       grpc::CallbackServerContext* context,
+                       const grpcarch::ComputeRequest* request,
+                       grpcarch::ComputeResponse* response,
+                       const StageTimer& timer)
+            : service_(service), context_(context), request_(request), response_(response),
+              subcall_deadline_(service->SubcallDeadline(context)),
+              operation_(ParseOperation(request->operation())),
+              timer_(timer) {
+            span_ = service_->StartServerSpan(service_->compute_attrs_, *context);
+            span_->SetAttribute("operation", request_->operation());
+            span_->SetAttribute("input_count", static_cast<int>(request_->input_values_size()));
+
+            service_->LogInfo([this] {
+                return "Compute called - operation: " + request_->operation() +
+                       ", inputs: " + std::to_string(request_->input_values_size());
+            });
+            timer_.End(Stage::kTelemetry);
+
+            // Simulate computation (8-12ms) without blocking a thread
+            std::uniform_int_distribution<> delay_dist(8, 12);
+            auto deadline = std::chrono::system_clock::now() +
+                            std::chrono::milliseconds(delay_dist(DelayGenerator()));
+            alarm_.Set(deadline, [this](bool ok) { OnComputeDelayElapsed(ok); });
+        }
+
+        void OnCancel() override {
+            // A pending compute delay completes early with a failure; a queued
+            // validation is shared with other calls and runs to completion
+            alarm_.Cancel();
+        }
+
+        void OnDone() override {
+            service_->Release();
+            delete this;
+        }
+
+    private:
+        ServiceEImpl* service_;
+        grpc::CallbackServerContext* context_;
+        const grpcarch::ComputeRequest* request_;
+        grpcarch::ComputeResponse* response_;
+        ValidationBatcher::Deadline subcall_deadline_;
+        Operation operation_;
+        StageTimer timer_;  // Started by Compute() before the cache lookup
+
+        SpanPtr span_;
+        Validation validation_;
+
+        grpc::Alarm alarm_;
+
+        // One generator per thread instead of a random_device per request
+        static std::mt19937& DelayGenerator() {
+            thread_local std::mt19937 gen(std::random_device{}());
+            return gen;
+        }
+
+        void OnComputeDelayElapsed(bool ok) {
+            timer_.End(Stage::kComputeDelay);
+            if (!ok) {
+                span_->SetStatus(trace_api::StatusCode::kError, "Cancelled");
+                span_->End();
+                Finish(grpc::Status::CANCELLED);
+                return;
             }
-        } else if (operation == "transform") {
-            for (const auto& val : request->input_values()) {
-                results.push_back(val * 2.0 + 1.0);
+
+            RunOperation();
+            timer_.End(Stage::kKernel);
+            StartValidation();
+        }
+
+        void RunOperation() {
+            // Kernels read the request's storage directly and write into the
+            // response's, after a single Reserve() of the final size
+            const auto& input = request_->input_values();
+            auto* output = response_->mutable_output_values();
+            const size_t n = static_cast<size_t>(input.size());
+
+            switch (operation_) {
+                case Operation::kSum:
+                    output->Reserve(1);
+                    output->AddAlreadyReserved(service_->compute_pool_->Sum(input.data(), n));
+                    break;
+                case Operation::kAverage:
+                    if (n > 0) {
+                        output->Reserve(1);
+                        output->AddAlreadyReserved(service_->compute_pool_->Sum(input.data(), n) / n);
+                    }
+                    break;
+                case Operation::kTransform: {
+                    // Claim the output range without zero-filling it first
+                    output->Reserve(input.size());
+                    double* out = output->AddNAlreadyReserved(input.size());
+                    service_->compute_pool_->Transform(input.data(), out, n, 2.0, 1.0);
+                    break;
+                }
+                case Operation::kEcho:
+                    output->CopyFrom(input);
+                    break;
             }
-        } else {
-            // Default: echo values
-            for (const auto& val : request->input_values()) {
-                results.push_back(val);
+        }
+
+        void StartValidation() {
+            service_->StartValidation(validation_, span_, subcall_deadline_, "compute-result",
+                "Computed " + std::to_string(response_->output_values_size()) + " values",
+                [this](const grpc::Status& status) { OnValidated(status); });
+        }
+
+        void OnValidated(const grpc::Status& validation_status) {
+            timer_.End(Stage::kValidation);
+            service_->FinishValidation(validation_, validation_status, response_->mutable_status());
+            if (validation_status.ok()) {
+                const auto& input = request_->input_values();
+                const auto& output = response_->output_values();
+                service_->result_cache_.Insert(static_cast<uint32_t>(operation_),
+                    input.data(), static_cast<size_t>(input.size()),
+                    output.data(), static_cast<size_t>(output.size()));
+                timer_.End(Stage::kCache);
             }
+
+            double duration_ms = timer_.TotalMilliseconds();
+            SetComputeMetrics(response_->mutable_metrics(), duration_ms, response_->output_values_size());
+
+            span_->SetAttribute("output_count", response_->output_values_size());
+            service_->LogInfo([duration_ms] {
+                return "Computation complete (duration: " + std::to_string(duration_ms) + "ms)";
+            });
+
+            const auto status = validation_status.ok() ? CallStatus::kOk : CallStatus::kValidationFailed;
+            service_->RecordCall(service_->compute_attrs_, span_, status, duration_ms, timer_);
+            service_->MaybeCompress(context_, *response_);
+            Finish(grpc::Status::OK);
         }
+    };
+
+    // State of one ComputeStream call. Reads and writes strictly alternate,
+    // so at most one input chunk and one output chunk are held at a time;
+    // "sum"/"average" keep only a running compensated sum and count.
+    class ComputeStreamReactor final
+        : public grpc::ServerBidiReactor<grpcarch::ComputeStreamRequest,
+                                         grpcarch::ComputeStreamResponse> {
+    public:
+        ComputeStreamReactor(ServiceEImpl* service, grpc::CallbackServerContext* context)
+            : service_(service), context_(context), subcall_deadline_(service->SubcallDeadline(context)) {
+            if (service_->CompressionEnabled()) context->set_compression_level(GRPC_COMPRESS_LEVEL_LOW);
+            span_ = service_->StartServerSpan(service_->stream_attrs_, *context);
+            timer_.End(Stage::kTelemetry);
+
+            StartRead(&chunk_);
+        }
+
+        void OnReadDone(bool ok) override {
+            timer_.End(Stage::kStreamIo);
+            if (!ok) {
+                // A cancelled call also ends the reads; there is nobody left to validate for
+                if (context_->IsCancelled()) {
+                    span_->SetStatus(trace_api::StatusCode::kError, "Cancelled");
+                    span_->End();
+                    Finish(grpc::Status::CANCELLED);
+                    return;
+                }
+                // Client half-closed: validate once for the whole stream
+                StartValidation();
+                return;
+            }
+
+            if (chunks_ == 0) {
+                operation_ = ParseOperation(chunk_.operation());
+                span_->SetAttribute("operation", chunk_.operation());
+                service_->LogInfo([this] {
+                    return "ComputeStream started - operation: " + chunk_.operation();
+                });
+            }
+            chunks_++;
 
-        // Call Service D to validate results
-        auto validation_span = tracer_->StartSpan("CallServiceD");
-        {
-            auto validation_scope = tracer_->WithActiveSpan(validation_span);
-
-            grpcarch::ValidationRequest validation_req;
-            validation_req.mutable_metadata()->set_caller_service("service-e");
-            validation_req.mutable_data()->set_id("compute-result");
-            validation_req.mutable_data()->set_content(
-                "Computed " + std::to_string(results.size()) + " values");
-
-            grpcarch::ValidationResponse validation_resp;
-            grpc::ClientContext client_ctx;
-
-            LogInfo("Calling Service D for validation");
-            auto validation_status = service_d_stub_->ValidateData(
-                &client_ctx, validation_req, &validation_resp);
-
-            if (!validation_status.ok()) {
-                validation_span->SetStatus(trace_api::StatusCode::kError,
-                    validation_status.error_message());
-                LogWarn("Service D validation failed: " + validation_status.error_message());
-
-                // Still return our results, but note the validation failure
-                response->mutable_status()->set_success(false);
-                response->mutable_status()->set_message(
-                    "Computation complete but validation failed: " +
-                    validation_status.error_message());
+            const bool has_output = ProcessChunk();
+            timer_.End(Stage::kKernel);
+            if (has_output) {
+                StartWrite(&output_, service_->StreamWriteOptions(output_));
             } else {
-                validation_span->SetStatus(trace_api::StatusCode::kOk, "");
-                response->mutable_status()->set_success(true);
-                response->mutable_status()->set_message("Computation and validation successful");
+                chunk_.Clear();
+                StartRead(&chunk_);
             }
         }
-        validation_span->End();
 
-        // Set output values
-        for (const auto& result : results) {
-            response->add_output_values(result);
+        void OnWriteDone(bool ok) override {
+            if (!ok) {
+                span_->SetStatus(trace_api::StatusCode::kError, "Stream write failed");
+                span_->End();
+                Finish(grpc::Status(grpc::StatusCode::UNAVAILABLE, "Stream write failed"));
+                return;
+            }
+            output_.Clear();
+            chunk_.Clear();
+            StartRead(&chunk_);
         }
 
-        // Set metrics
-        auto end = std::chrono::high_resolution_clock::now();
-        double duration_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        void OnDone() override {
+            service_->Release();
+            delete this;
+        }
 
-        auto* metrics = response->mutable_metrics();
-        metrics->set_compute_time_ms(static_cast<int64_t>(duration_ms));
-        metrics->set_operations_performed(results.size());
-        metrics->set_memory_used_mb(0.5);
+    private:
+        ServiceEImpl* service_;
+        grpc::CallbackServerContext* context_;
+        ValidationBatcher::Deadline subcall_deadline_;
+        StageTimer timer_;
+        Operation operation_ = Operation::kEcho;
+
+        grpcarch::ComputeStreamRequest chunk_;
+        grpcarch::ComputeStreamResponse output_;
+
+        // Running state across chunks
+        kernels::CompensatedSum sum_;
+        int64_t values_processed_ = 0;
+        int64_t values_emitted_ = 0;
+        int64_t chunks_ = 0;
+
+        SpanPtr span_;
+        Validation validation_;
+
+        // Fold one chunk into the running state; returns true if it produced
+        // output that has to be written before the next read
+        bool ProcessChunk() {
+            const auto& input = chunk_.input_values();
+            const size_t n = static_cast<size_t>(input.size());
+            values_processed_ += input.size();
+
+            switch (operation_) {
+                case Operation::kSum:
+                case Operation::kAverage:
+                    sum_.Add(service_->compute_pool_->Sum(input.data(), n));
+                    return false;
+                case Operation::kTransform: {
+                    auto* output = output_.mutable_output_values();
+                    output->Reserve(input.size());
+                    double* out = output->AddNAlreadyReserved(input.size());
+                    service_->compute_pool_->Transform(input.data(), out, n, 2.0, 1.0);
+                    break;
+                }
+                case Operation::kEcho:
+                    output_.mutable_output_values()->Swap(chunk_.mutable_input_values());
+                    break;
+            }
 
-        // Record telemetry
-        auto ctx = opentelemetry::context::Context{};
-        request_counter_->Add(1, {{"method", "Compute"}, {"status", "ok"}}, ctx);
-        latency_histogram_->Record(duration_ms, {{"method", "Compute"}}, ctx);
+            values_emitted_ += output_.output_values_size();
+            output_.set_values_processed(values_processed_);
+            return true;
+        }
 
-        span->SetAttribute("duration_ms", duration_ms);
-        span->SetAttribute("output_count", static_cast<int>(results.size()));
-        span->SetStatus(trace_api::StatusCode::kOk, "");
-        span->End();
+        void StartValidation() {
+            service_->StartValidation(validation_, span_, subcall_deadline_, "compute-stream-result",
+                "Computed " + std::to_string(values_processed_) + " values in " +
+                    std::to_string(chunks_) + " chunks",
+                [this](const grpc::Status& status) { OnValidated(status); });
+        }
 
-        LogInfo("Computation complete (duration: " + std::to_string(duration_ms) + "ms)");
+        void OnValidated(const grpc::Status& validation_status) {
+            timer_.End(Stage::kValidation);
+            output_.Clear();
+            output_.set_final(true);
+            output_.set_values_processed(values_processed_);
+            service_->FinishValidation(validation_, validation_status, output_.mutable_status());
+
+            // Aggregates are only known once the stream has ended
+            if (operation_ == Operation::kSum) {
+                output_.add_output_values(sum_.Result());
+            } else if (operation_ == Operation::kAverage && values_processed_ > 0) {
+                output_.add_output_values(sum_.Result() / values_processed_);
+            }
 
-        return grpc::Status::OK;
-    }
+            timer_.End(Stage::kKernel);
+            double duration_ms = timer_.TotalMilliseconds();
+
+            SetComputeMetrics(output_.mutable_metrics(), duration_ms,
+                static_cast<int32_t>(values_emitted_ + output_.output_values_size()));
+
+            span_->SetAttribute("input_count", values_processed_);
+            span_->SetAttribute("chunk_count", chunks_);
+            service_->LogInfo([duration_ms, this] {
+                return "ComputeStream complete (chunks: " + std::to_string(chunks_) +
+                       ", duration: " + std::to_string(duration_ms) + "ms)";
+            });
+
+            const auto status = validation_status.ok() ? CallStatus::kOk : CallStatus::kValidationFailed;
+            service_->RecordCall(service_->stream_attrs_, span_, status, duration_ms, timer_);
+            StartWriteAndFinish(&output_, service_->StreamWriteOptions(output_), grpc::Status::OK);
+        }
+    };
 
-private:
     std::string service_d_addr_;
+    ComputePool* compute_pool_;
+    ResultCache result_cache_;
+    ServingOptions serving_opts_;
+    std::atomic<size_t> in_flight_{0};
     opentelemetry::nostd::shared_ptr<trace_api::Tracer> tracer_;
     opentelemetry::nostd::shared_ptr<logs_api::Logger> logger_;
     std::unique_ptr<metrics_api::Counter<uint64_t>> request_counter_;
     std::unique_ptr<metrics_api::Histogram<double>> latency_histogram_;
-    std::unique_ptr<grpcarch::ServiceD::Stub> service_d_stub_;
+    std::unique_ptr<metrics_api::Histogram<double>> stage_histogram_;
+    std::unique_ptr<metrics_api::Counter<uint64_t>> cache_hit_counter_;
+    std::unique_ptr<metrics_api::Counter<uint64_t>> cache_miss_counter_;
+    const MethodAttributes compute_attrs_{"Compute"};
+    const MethodAttributes stream_attrs_{"ComputeStream"};
+    const opentelemetry::context::Context no_context_{};  // For measurements without a span
+    std::unique_ptr<ChannelPool> service_d_channels_;
+    std::unique_ptr<ValidationBatcher> validation_batcher_;  // Declared after the channels it uses
+
+    logs_api::Severity min_log_severity_;
+
+    // A message is either a string or a callable producing one; the callable
+    // only runs when the severity passes the filter, so dropped messages are
+    // never formatted
+    template <typename Message>
+    void Log(logs_api::Severity severity, Message&& message) {
+        if (severity < min_log_severity_) return;
+        if constexpr (std::is_invocable_v<Message>) {
+            logger_->Log(severity, message());
+        } else {
+            logger_->Log(severity, message);
+        }
+    }
 
-    void LogInfo(const std::string& message) {
-        logger_->Info(message);
+    template <typename Message>
+    void LogInfo(Message&& message) {
+        Log(logs_api::Severity::kInfo, std::forward<Message>(message));
     }
 
-    void LogWarn(const std::string& message) {
-        logger_->Warn(message);
+    template <typename Message>
+    void LogWarn(Message&& message) {
+        Log(logs_api::Severity::kWarn, std::forward<Message>(message));
     }
 
-    void LogError(const std::string& message) {
-        logger_->Error(message);
+    template <typename Message>
+    void LogError(Message&& message) {
+        Log(logs_api::Severity::kError, std::forward<Message>(message));
     }
 };
 
@@ -208,11 +769,34 @@ void InitTracer() {
 
     otlp::OtlpGrpcExporterOptions opts;
     opts.endpoint = otlp_endpoint;
+    opts.compression = OtlpCompression("OTEL_EXPORTER_OTLP_TRACES_COMPRESSION");
 
     auto exporter = otlp::OtlpGrpcExporterFactory::Create(opts);
 
     trace_sdk::BatchSpanProcessorOptions bsp_opts;
-    auto processor = trace_sdk::BatchSpanProcessorFactory::Create(std::move(exporter), bsp_opts);
+    std::unique_ptr<trace_sdk::SpanProcessor> processor =
+        trace_sdk::BatchSpanProcessorFactory::Create(std::move(exporter), bsp_opts);
+
+    // Tail sampling keeps every error trace and slow outlier but only a
+    // share of ordinary ones; it is off while the keep ratio is 1
+    TailSamplingOptions tail_opts;
+    tail_opts.keep_ratio = std::min(1.0, EnvDouble("SERVICE_E_TRACE_TAIL_RATIO", tail_opts.keep_ratio));
+    tail_opts.latency_percentile = EnvDouble("SERVICE_E_TRACE_TAIL_PERCENTILE", tail_opts.latency_percentile);
+    if (tail_opts.latency_percentile >= 100.0) tail_opts.latency_percentile = 0.0;
+    tail_opts.window = std::chrono::milliseconds(
+        EnvSize("SERVICE_E_TRACE_TAIL_WINDOW_MS", tail_opts.window.count()));
+    tail_opts.max_spans = EnvSize("SERVICE_E_TRACE_TAIL_MAX_SPANS", tail_opts.max_spans);
+    if (tail_opts.keep_ratio < 1.0) {
+        processor = std::make_unique<TailSamplingProcessor>(std::move(processor), tail_opts);
+        std::cout << "[Service E] Tail sampling: keep ratio " << tail_opts.keep_ratio
+                  << ", latency p" << tail_opts.latency_percentile
+                  << ", window " << tail_opts.window.count() << "ms" << std::endl;
+    }
+
+    // Head sampling follows the caller's decision and samples new traces at a ratio
+    double head_ratio = std::min(1.0, EnvDouble("SERVICE_E_TRACE_SAMPLE_RATIO", 1.0));
+    auto sampler = trace_sdk::ParentBasedSamplerFactory::Create(
+        trace_sdk::TraceIdRatioBasedSamplerFactory::Create(head_ratio));
 
     auto resource_attrs = resource::Resource::Create({
         {resource::SemanticConventions::kServiceName, "service-e"},
@@ -220,7 +804,7 @@ void InitTracer() {
     });
 
     std::shared_ptr<trace_api::TracerProvider> provider =
-        trace_sdk::TracerProviderFactory::Create(std::move(processor), resource_attrs);
+        trace_sdk::TracerProviderFactory::Create(std::move(processor), resource_attrs, std::move(sampler));
 
     trace_api::Provider::SetTracerProvider(
         opentelemetry::nostd::shared_ptr<trace_api::TracerProvider>(provider));
@@ -230,12 +814,76 @@ void InitTracer() {
     opentelemetry::context::propagation::GlobalTextMapPropagator::SetGlobalPropagator(propagator);
 }
 
+// Histogram bucket boundaries in ms. Cached and shed calls finish well
+// under a millisecond, computed ones after the 8-12ms compute delay plus
+// the ServiceD round trip; stages go down to microseconds.
+const std::vector<double> kRequestDurationBoundsMs = {
+    0.25, 0.5, 1, 2, 5, 8, 10, 12, 15, 20, 30, 50, 100, 250, 1000};
+const std::vector<double> kStageDurationBoundsMs = {
+    0.01, 0.05, 0.1, 0.25, 0.5, 1, 2, 5, 10, 20, 50, 100};
+
+// Exponential histograms rescale to fit the recorded range into this many buckets
+constexpr size_t kExponentialHistogramMaxBuckets = 64;
+
+// OTEL_EXPORTER_OTLP_METRICS_TEMPORALITY_PREFERENCE: cumulative (default),
+// delta or lowmemory. Delta exports only the series that changed since the
+// previous collection, and lets the SDK drop their state after each export.
+otlp::PreferredAggregationTemporality MetricsTemporality() {
+    const char* value = std::getenv("OTEL_EXPORTER_OTLP_METRICS_TEMPORALITY_PREFERENCE");
+    if (!value || !*value) return otlp::PreferredAggregationTemporality::kCumulative;
+
+    std::string temporality = Lowercase(value);
+    if (temporality == "cumulative") return otlp::PreferredAggregationTemporality::kCumulative;
+    if (temporality == "delta") return otlp::PreferredAggregationTemporality::kDelta;
+    if (temporality == "lowmemory") return otlp::PreferredAggregationTemporality::kLowMemory;
+    std::cerr << "[Service E] Ignoring unknown metrics temporality " << value << std::endl;
+    return otlp::PreferredAggregationTemporality::kCumulative;
+}
+
+// OTEL_EXPORTER_OTLP_METRICS_DEFAULT_HISTOGRAM_AGGREGATION:
+// explicit_bucket_histogram (default) or base2_exponential_bucket_histogram
+bool ExponentialHistograms() {
+    const char* value = std::getenv("OTEL_EXPORTER_OTLP_METRICS_DEFAULT_HISTOGRAM_AGGREGATION");
+    if (!value || !*value) return false;
+
+    std::string aggregation = Lowercase(value);
+    if (aggregation == "base2_exponential_bucket_histogram") return true;
+    if (aggregation != "explicit_bucket_histogram") {
+        std::cerr << "[Service E] Ignoring unknown histogram aggregation " << value << std::endl;
+    }
+    return false;
+}
+
+// Aggregate one of our histograms with the given bounds, or exponentially
+void AddHistogramView(metrics_sdk::MeterContext& context, const std::string& name,
+                      const std::vector<double>& bounds_ms, bool exponential) {
+    auto aggregation = metrics_sdk::AggregationType::kHistogram;
+    std::shared_ptr<metrics_sdk::AggregationConfig> config;
+    if (exponential) {
+        auto exponential_config = std::make_shared<metrics_sdk::Base2ExponentialHistogramAggregationConfig>();
+        exponential_config->max_buckets_ = kExponentialHistogramMaxBuckets;
+        aggregation = metrics_sdk::AggregationType::kBase2ExponentialHistogram;
+        config = std::move(exponential_config);
+    } else {
+        auto explicit_config = std::make_shared<metrics_sdk::HistogramAggregationConfig>();
+        explicit_config->boundaries_ = bounds_ms;
+        config = std::move(explicit_config);
+    }
+
+    context.AddView(
+        metrics_sdk::InstrumentSelectorFactory::Create(metrics_sdk::InstrumentType::kHistogram, name, ""),
+        metrics_sdk::MeterSelectorFactory::Create("service-e", "1.0.0", ""),
+        metrics_sdk::ViewFactory::Create(name, "", "", aggregation, std::move(config)));
+}
+
 void InitMetrics() {
     const char* endpoint = std::getenv("OTEL_EXPORTER_OTLP_ENDPOINT");
     std::string otlp_endpoint = endpoint ? endpoint : "http://localhost:4317";
 
     otlp::OtlpGrpcMetricExporterOptions opts;
     opts.endpoint = otlp_endpoint;
+    opts.compression = OtlpCompression("OTEL_EXPORTER_OTLP_METRICS_COMPRESSION");
+    opts.aggregation_temporality = MetricsTemporality();
 
     auto exporter = otlp::OtlpGrpcMetricExporterFactory::Create(opts);
 
@@ -255,6 +903,12 @@ void InitMetrics() {
     auto context = metrics_sdk::MeterContextFactory::Create();
     context->AddMetricReader(std::move(reader));
 
+    // Latency histograms get buckets sized for this service instead of the
+    // SDK's default 0-10000 spread
+    const bool exponential = ExponentialHistograms();
+    AddHistogramView(*context, "service_e_request_duration_ms", kRequestDurationBoundsMs, exponential);
+    AddHistogramView(*context, "service_e_stage_duration_ms", kStageDurationBoundsMs, exponential);
+
     auto provider = metrics_sdk::MeterProviderFactory::Create(std::move(context));
 
     metrics_api::Provider::SetMeterProvider(
@@ -267,6 +921,7 @@ void InitLogs() {
 
     otlp::OtlpGrpcLogRecordExporterOptions opts;
     opts.endpoint = otlp_endpoint;
+    opts.compression = OtlpCompression("OTEL_EXPORTER_OTLP_LOGS_COMPRESSION");
 
     auto exporter = otlp::OtlpGrpcLogRecordExporterFactory::Create(opts);
 
@@ -292,7 +947,57 @@ void RunServer() {
     const char* service_d_env = std::getenv("SERVICE_D_ADDR");
     std::string service_d_addr = service_d_env ? service_d_env : "localhost:50054";
 
-    ServiceEImpl service(service_d_addr);
+    // Large inputs are split across a pool of compute threads
+    ComputePoolOptions pool_opts;
+    pool_opts.threads = EnvSize("SERVICE_E_COMPUTE_THREADS", pool_opts.threads);
+    pool_opts.parallel_threshold = EnvSize("SERVICE_E_PARALLEL_THRESHOLD", pool_opts.parallel_threshold);
+    pool_opts.chunk_size = EnvSize("SERVICE_E_CHUNK_SIZE", pool_opts.chunk_size);
+    ComputePool compute_pool(pool_opts);
+
+    // Calls to ServiceD are spread over several connections; set the LB
+    // policy to round_robin with a dns:/// address to balance across replicas
+    ChannelPoolOptions channel_opts;
+    channel_opts.channels = EnvSize("SERVICE_E_SERVICE_D_CHANNELS", channel_opts.channels);
+    if (const char* lb_env = std::getenv("SERVICE_E_SERVICE_D_LB_POLICY")) channel_opts.lb_policy = lb_env;
+    channel_opts.keepalive_time_ms = static_cast<int>(
+        EnvSize("SERVICE_E_KEEPALIVE_TIME_MS", channel_opts.keepalive_time_ms));
+    channel_opts.keepalive_timeout_ms = static_cast<int>(
+        EnvSize("SERVICE_E_KEEPALIVE_TIMEOUT_MS", channel_opts.keepalive_timeout_ms));
+
+    // ServiceD validations are coalesced into ValidateBatch calls; a batch
+    // size of 1 sends each one on its own
+    ValidationBatcherOptions batcher_opts;
+    batcher_opts.max_batch_size = EnvSize("SERVICE_E_VALIDATION_BATCH_SIZE", batcher_opts.max_batch_size);
+    batcher_opts.max_delay = std::chrono::microseconds(
+        EnvSize("SERVICE_E_VALIDATION_BATCH_DELAY_US", batcher_opts.max_delay.count()));
+
+    // Opt-in cache of validated Compute results (SERVICE_E_RESULT_CACHE_BYTES > 0)
+    ResultCacheOptions cache_opts;
+    cache_opts.max_bytes = EnvSize("SERVICE_E_RESULT_CACHE_BYTES", cache_opts.max_bytes);
+    cache_opts.ttl = std::chrono::milliseconds(
+        EnvSize("SERVICE_E_RESULT_CACHE_TTL_MS", cache_opts.ttl.count()));
+    cache_opts.shards = EnvSize("SERVICE_E_RESULT_CACHE_SHARDS", cache_opts.shards);
+
+    // Calls beyond max_in_flight are shed, as are Compute calls with less
+    // deadline left than they are expected to take
+    ServingOptions serving_opts;
+    serving_opts.max_in_flight = EnvSize("SERVICE_E_MAX_IN_FLIGHT", serving_opts.max_in_flight);
+    serving_opts.deadline_margin = std::chrono::milliseconds(
+        EnvSize("SERVICE_E_DEADLINE_MARGIN_MS", serving_opts.deadline_margin.count()));
+    serving_opts.compute_cost = std::chrono::milliseconds(
+        EnvSize("SERVICE_E_COMPUTE_COST_MS", serving_opts.compute_cost.count()));
+    // gRPC turns the compression level into an algorithm from the client's
+    // grpc-accept-encoding, so clients that accept none still get plain responses
+    serving_opts.compression_min_bytes = EnvSize("SERVICE_E_RESPONSE_COMPRESSION_BYTES",
+                                                 serving_opts.compression_min_bytes);
+
+    ServiceEImpl service(service_d_addr, &compute_pool, channel_opts, batcher_opts, cache_opts,
+                         serving_opts);
+
+    // Compute requests and responses are placed on pooled arenas; the
+    // allocator must outlive the server
+    ArenaMessageAllocator<grpcarch::ComputeRequest, grpcarch::ComputeResponse> compute_allocator;
+    service.SetMessageAllocatorFor_Compute(&compute_allocator);
 
     grpc::EnableDefaultHealthCheckService(true);
     grpc::ServerBuilder builder;
@@ -302,7 +1007,18 @@ void RunServer() {
     std::unique_ptr<grpc::Server> server(builder.BuildAndStart());
     std::cout << "[Service E] Server listening on " << server_address << std::endl;
     std::cout << "[Service E] Computation service (C++) ready" << std::endl;
-    std::cout << "[Service E] Service D address: " << service_d_addr << std::endl;
+    std::cout << "[Service E] Service D address: " << service_d_addr
+              << " (" << channel_opts.channels << " channels"
+              << (channel_opts.lb_policy.empty() ? "" : ", " + channel_opts.lb_policy) << ")" << std::endl;
+    std::cout << "[Service E] Compute kernels: " << kernels::ActiveIsa()
+              << ", threads: " << compute_pool.threads()
+              << ", parallel threshold: " << pool_opts.parallel_threshold << std::endl;
+    std::cout << "[Service E] Validation batching: up to " << batcher_opts.max_batch_size
+              << " requests, " << batcher_opts.max_delay.count() << "us delay" << std::endl;
+    if (cache_opts.max_bytes > 0) {
+        std::cout << "[Service E] Result cache: " << cache_opts.max_bytes << " bytes, "
+                  << cache_opts.ttl.count() << "ms TTL, " << cache_opts.shards << " shards" << std::endl;
+    }
 
     server->Wait();
 }
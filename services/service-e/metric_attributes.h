@@ -0,0 +1,102 @@
+// Pre-built attribute sets for service-e's hot instruments
+//
+// Passing attributes as an initializer list builds a fresh list of
+// key/value pairs for every measurement. The sets here are built once per
+// method and handed to the SDK as a KeyValueIterable, which it hashes to
+// find the series, so recording a measurement allocates nothing on our side.
+// Keys and values must be string literals or otherwise outlive the set.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "opentelemetry/common/attribute_value.h"
+#include "opentelemetry/common/key_value_iterable.h"
+#include "opentelemetry/nostd/function_ref.h"
+#include "opentelemetry/nostd/string_view.h"
+
+#include "stage_timer.h"
+
+// Outcome of a call, as recorded in the status attribute
+enum class CallStatus : uint8_t {
+    kOk,
+    kValidationFailed,   // Computed, but ServiceD rejected or did not answer
+    kDeadlineExceeded,   // Shed: less deadline left than the call needs
+    kOverloaded,         // Shed: too many calls in progress
+    kCount
+};
+
+constexpr size_t kCallStatusCount = static_cast<size_t>(CallStatus::kCount);
+
+inline const char* CallStatusName(CallStatus status) {
+    switch (status) {
+        case CallStatus::kOk: return "ok";
+        case CallStatus::kValidationFailed: return "validation_failed";
+        case CallStatus::kDeadlineExceeded: return "deadline_exceeded";
+        case CallStatus::kOverloaded: return "overloaded";
+        default: return "unknown";
+    }
+}
+
+// A fixed set of N attributes
+template <size_t N>
+class AttributeSet final : public opentelemetry::common::KeyValueIterable {
+public:
+    using Attribute = std::pair<opentelemetry::nostd::string_view, opentelemetry::common::AttributeValue>;
+
+    AttributeSet() = default;
+    explicit AttributeSet(const std::array<Attribute, N>& attributes) : attributes_(attributes) {}
+
+    bool ForEachKeyValue(opentelemetry::nostd::function_ref<
+                             bool(opentelemetry::nostd::string_view, opentelemetry::common::AttributeValue)>
+                             callback) const noexcept override {
+        for (const auto& [key, value] : attributes_) {
+            if (!callback(key, value)) return false;
+        }
+        return true;
+    }
+
+    size_t size() const noexcept override { return N; }
+
+private:
+    std::array<Attribute, N> attributes_{};
+};
+
+// Every attribute set one RPC method records with
+class MethodAttributes {
+public:
+    explicit MethodAttributes(const char* method) : name_(method), method_({{{"method", method}}}) {
+        for (size_t i = 0; i < kCallStatusCount; i++) {
+            statuses_[i] = AttributeSet<2>({{{"method", method},
+                                             {"status", CallStatusName(static_cast<CallStatus>(i))}}});
+        }
+        for (size_t i = 0; i < kStageCount; i++) {
+            stages_[i] = AttributeSet<2>({{{"method", method},
+                                           {"stage", StageName(static_cast<Stage>(i))}}});
+        }
+    }
+
+    const char* name() const { return name_; }
+
+    // {method}
+    const opentelemetry::common::KeyValueIterable& Method() const { return method_; }
+
+    // {method, status}
+    const opentelemetry::common::KeyValueIterable& Status(CallStatus status) const {
+        return statuses_[static_cast<size_t>(status)];
+    }
+
+    // {method, stage}
+    const opentelemetry::common::KeyValueIterable& ForStage(Stage stage) const {
+        return stages_[static_cast<size_t>(stage)];
+    }
+
+private:
+    const char* name_;
+    AttributeSet<1> method_;
+    std::array<AttributeSet<2>, kCallStatusCount> statuses_;
+    std::array<AttributeSet<2>, kStageCount> stages_;
+};
@@ -0,0 +1,109 @@
+#include "result_cache.h"
+
+#include <cstring>
+#include <iterator>
+
+ResultCache::ResultCache(const ResultCacheOptions& options) : options_(options) {
+    if (options_.max_bytes == 0) return;
+    if (options_.shards == 0) options_.shards = 1;
+
+    shard_budget_ = options_.max_bytes / options_.shards;
+    for (size_t i = 0; i < options_.shards; i++) {
+        shards_.push_back(std::make_unique<Shard>());
+    }
+}
+
+// Hashes the raw bits of the inputs, four independent lanes at a time so
+// the multiplies overlap; cheap next to even a single pass of the kernels
+uint64_t ResultCache::Hash(uint32_t operation, const double* inputs, size_t n) {
+    constexpr uint64_t kMul = 0x9E3779B97F4A7C15ull;
+    auto mix = [](uint64_t h, uint64_t v) {
+        h ^= v * kMul;
+        h ^= h >> 29;
+        return h * 0xBF58476D1CE4E5B9ull;
+    };
+
+    uint64_t lanes[4] = {operation + 1, n, kMul, ~kMul};
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        uint64_t words[4];
+        std::memcpy(words, inputs + i, sizeof(words));
+        for (int lane = 0; lane < 4; lane++) lanes[lane] = mix(lanes[lane], words[lane]);
+    }
+    for (; i < n; i++) {
+        uint64_t word;
+        std::memcpy(&word, inputs + i, sizeof(word));
+        lanes[0] = mix(lanes[0], word);
+    }
+
+    uint64_t h = lanes[0];
+    for (int lane = 1; lane < 4; lane++) h = mix(h, lanes[lane]);
+    return h ^ (h >> 31);
+}
+
+bool ResultCache::Matches(const Entry& entry, uint32_t operation, const double* inputs, size_t n) {
+    return entry.operation == operation && entry.inputs.size() == n &&
+           (n == 0 || std::memcmp(entry.inputs.data(), inputs, n * sizeof(double)) == 0);
+}
+
+void ResultCache::Erase(Shard& shard, std::list<Entry>::iterator it) {
+    shard.bytes -= it->bytes;
+    shard.index.erase(it->hash);
+    shard.lru.erase(it);
+}
+
+bool ResultCache::Lookup(uint32_t operation, const double* inputs, size_t n,
+                         google::protobuf::RepeatedField<double>* output) {
+    if (!enabled()) return false;
+
+    const uint64_t hash = Hash(operation, inputs, n);
+    Shard& shard = ShardFor(hash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto found = shard.index.find(hash);
+    if (found == shard.index.end()) return false;
+
+    auto it = found->second;
+    if (std::chrono::steady_clock::now() >= it->expires) {
+        Erase(shard, it);
+        return false;
+    }
+    if (!Matches(*it, operation, inputs, n)) return false;
+
+    shard.lru.splice(shard.lru.begin(), shard.lru, it);
+    output->Reserve(output->size() + static_cast<int>(it->output.size()));
+    output->Add(it->output.begin(), it->output.end());
+    return true;
+}
+
+void ResultCache::Insert(uint32_t operation, const double* inputs, size_t n,
+                         const double* output, size_t output_n) {
+    if (!enabled()) return;
+
+    const size_t bytes = sizeof(Entry) + (n + output_n) * sizeof(double);
+    if (bytes > shard_budget_) return;
+
+    const uint64_t hash = Hash(operation, inputs, n);
+    Shard& shard = ShardFor(hash);
+
+    // Build the entry before taking the lock; copying large inputs is the slow part
+    Entry entry{hash, operation,
+                std::vector<double>(inputs, inputs + n),
+                std::vector<double>(output, output + output_n),
+                std::chrono::steady_clock::now() + options_.ttl,
+                bytes};
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    // Same inputs refresh the entry; a colliding key replaces it
+    auto found = shard.index.find(hash);
+    if (found != shard.index.end()) Erase(shard, found->second);
+
+    while (shard.bytes + bytes > shard_budget_ && !shard.lru.empty()) {
+        Erase(shard, std::prev(shard.lru.end()));
+    }
+
+    shard.lru.push_front(std::move(entry));
+    shard.index.emplace(hash, shard.lru.begin());
+    shard.bytes += bytes;
+}
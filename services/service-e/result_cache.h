@@ -0,0 +1,71 @@
+// Sharded LRU cache of Compute results
+//
+// Entries are keyed by the operation and the exact input values. A 64-bit
+// hash picks the shard and bucket, and the stored inputs are compared on
+// lookup, so a hash collision is a miss rather than a wrong answer. Each
+// shard evicts least-recently-used entries to stay within its share of the
+// byte budget, and entries older than the TTL are never returned.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <google/protobuf/repeated_field.h>
+
+struct ResultCacheOptions {
+    size_t max_bytes = 0;                    // Total budget; 0 disables the cache
+    std::chrono::milliseconds ttl{60000};    // Age after which an entry is stale
+    size_t shards = 16;                      // Independent LRU lists, each with its own lock
+};
+
+class ResultCache {
+public:
+    explicit ResultCache(const ResultCacheOptions& options);
+
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    bool enabled() const { return !shards_.empty(); }
+
+    // Appends the cached output to *output and returns true on a fresh hit
+    bool Lookup(uint32_t operation, const double* inputs, size_t n,
+                google::protobuf::RepeatedField<double>* output);
+
+    // Stores (or refreshes) the output for these inputs; entries larger than
+    // a shard's budget are not cached
+    void Insert(uint32_t operation, const double* inputs, size_t n,
+                const double* output, size_t output_n);
+
+private:
+    struct Entry {
+        uint64_t hash;
+        uint32_t operation;
+        std::vector<double> inputs;
+        std::vector<double> output;
+        std::chrono::steady_clock::time_point expires;
+        size_t bytes;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::list<Entry> lru;   // Most recently used first
+        std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+        size_t bytes = 0;
+    };
+
+    static uint64_t Hash(uint32_t operation, const double* inputs, size_t n);
+    static bool Matches(const Entry& entry, uint32_t operation, const double* inputs, size_t n);
+    Shard& ShardFor(uint64_t hash) { return *shards_[(hash >> 32) % shards_.size()]; }
+    static void Erase(Shard& shard, std::list<Entry>::iterator it);
+
+    ResultCacheOptions options_;
+    size_t shard_budget_ = 0;
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
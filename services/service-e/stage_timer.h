@@ -0,0 +1,69 @@
+// Per-stage latency breakdown for service-e calls
+//
+// StageTimer splits one call's time into consecutive stages on the
+// monotonic clock: End(stage) charges everything since the previous mark
+// to that stage, so the stages of a call always add up to its total. Each
+// stage is recorded into its own histogram once the call completes.
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+enum class Stage : uint8_t {
+    kCache,         // Result cache lookups and inserts
+    kComputeDelay,  // Simulated compute delay
+    kKernel,        // Compute kernels
+    kStreamIo,      // Waiting on ComputeStream reads and writes
+    kValidation,    // ServiceD subcall, including batching delay
+    kTelemetry,     // Our own spans, logs and metrics
+    kCount
+};
+
+constexpr size_t kStageCount = static_cast<size_t>(Stage::kCount);
+
+inline const char* StageName(Stage stage) {
+    switch (stage) {
+        case Stage::kCache: return "cache";
+        case Stage::kComputeDelay: return "compute_delay";
+        case Stage::kKernel: return "kernel";
+        case Stage::kStreamIo: return "stream_io";
+        case Stage::kValidation: return "validation";
+        case Stage::kTelemetry: return "telemetry";
+        default: return "unknown";
+    }
+}
+
+class StageTimer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    StageTimer() : start_(Clock::now()), mark_(start_) {}
+
+    // Charge the time since the previous mark to stage
+    void End(Stage stage) {
+        const auto now = Clock::now();
+        const auto i = static_cast<size_t>(stage);
+        elapsed_[i] += now - mark_;
+        entered_ |= 1u << i;
+        mark_ = now;
+    }
+
+    bool Entered(Stage stage) const { return entered_ & (1u << static_cast<size_t>(stage)); }
+    double Milliseconds(Stage stage) const { return ToMilliseconds(elapsed_[static_cast<size_t>(stage)]); }
+
+    // Start of the call up to the latest mark
+    double TotalMilliseconds() const { return ToMilliseconds(mark_ - start_); }
+
+private:
+    static double ToMilliseconds(Clock::duration d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    }
+
+    Clock::time_point start_;
+    Clock::time_point mark_;
+    std::array<Clock::duration, kStageCount> elapsed_{};
+    uint32_t entered_ = 0;
+};
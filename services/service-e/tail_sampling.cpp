@@ -0,0 +1,239 @@
+#include "tail_sampling.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace trace_api = opentelemetry::trace;
+namespace trace_sdk = opentelemetry::sdk::trace;
+
+namespace {
+
+// Root durations the latency percentile is computed over
+constexpr size_t kLatencySamples = 1024;
+// Roots needed before the percentile is trusted, and between recomputations
+constexpr size_t kLatencyMinSamples = 128;
+constexpr size_t kLatencyUpdateInterval = 64;
+
+}  // namespace
+
+bool TraceIdRatioSampled(const uint8_t* trace_id, double ratio) {
+    if (ratio >= 1.0) return true;
+    if (ratio <= 0.0) return false;
+
+    uint64_t value = 0;
+    for (size_t i = 8; i < 16; i++) value = (value << 8) | trace_id[i];
+    // Top 53 bits, exactly representable as a double
+    return static_cast<double>(value >> 11) < ratio * 9007199254740992.0;
+}
+
+// Forwards everything to the delegate's recordable and keeps the few
+// fields the sampling decision needs
+class TailSamplingProcessor::TailRecordable final : public trace_sdk::Recordable {
+public:
+    explicit TailRecordable(std::unique_ptr<trace_sdk::Recordable> inner) : inner(std::move(inner)) {}
+
+    void SetIdentity(const trace_api::SpanContext& span_context,
+                     trace_api::SpanId parent_span_id) noexcept override {
+        std::memcpy(trace_id.data(), span_context.trace_id().Id().data(), trace_id.size());
+        inner->SetIdentity(span_context, parent_span_id);
+    }
+
+    void SetAttribute(opentelemetry::nostd::string_view key,
+                      const opentelemetry::common::AttributeValue& value) noexcept override {
+        inner->SetAttribute(key, value);
+    }
+
+    void AddEvent(opentelemetry::nostd::string_view name,
+                  opentelemetry::common::SystemTimestamp timestamp,
+                  const opentelemetry::common::KeyValueIterable& attributes) noexcept override {
+        inner->AddEvent(name, timestamp, attributes);
+    }
+
+    void AddLink(const trace_api::SpanContext& span_context,
+                 const opentelemetry::common::KeyValueIterable& attributes) noexcept override {
+        inner->AddLink(span_context, attributes);
+    }
+
+    void SetStatus(trace_api::StatusCode code,
+                   opentelemetry::nostd::string_view description) noexcept override {
+        error = code == trace_api::StatusCode::kError;
+        inner->SetStatus(code, description);
+    }
+
+    void SetName(opentelemetry::nostd::string_view name) noexcept override {
+        inner->SetName(name);
+    }
+
+    void SetTraceFlags(trace_api::TraceFlags trace_flags) noexcept override {
+        inner->SetTraceFlags(trace_flags);
+    }
+
+    void SetSpanKind(trace_api::SpanKind span_kind) noexcept override {
+        inner->SetSpanKind(span_kind);
+    }
+
+    void SetResource(const opentelemetry::sdk::resource::Resource& resource) noexcept override {
+        inner->SetResource(resource);
+    }
+
+    void SetStartTime(opentelemetry::common::SystemTimestamp start_time) noexcept override {
+        inner->SetStartTime(start_time);
+    }
+
+    void SetDuration(std::chrono::nanoseconds span_duration) noexcept override {
+        duration = span_duration;
+        inner->SetDuration(span_duration);
+    }
+
+    void SetInstrumentationScope(
+        const opentelemetry::sdk::instrumentationscope::InstrumentationScope& scope) noexcept override {
+        inner->SetInstrumentationScope(scope);
+    }
+
+    std::unique_ptr<trace_sdk::Recordable> inner;
+    TraceKey trace_id{};
+    bool is_root = false;
+    bool error = false;
+    std::chrono::nanoseconds duration{0};
+};
+
+size_t TailSamplingProcessor::TraceKeyHash::operator()(const TraceKey& key) const noexcept {
+    // Trace IDs are random; the low bytes are a good enough hash
+    uint64_t h;
+    std::memcpy(&h, key.data() + 8, sizeof(h));
+    return static_cast<size_t>(h);
+}
+
+TailSamplingProcessor::TailSamplingProcessor(std::unique_ptr<trace_sdk::SpanProcessor> delegate,
+                                             const TailSamplingOptions& options)
+    : delegate_(std::move(delegate)), options_(options) {
+    if (options_.max_spans == 0) options_.max_spans = TailSamplingOptions{}.max_spans;
+    latencies_.reserve(kLatencySamples);
+}
+
+TailSamplingProcessor::~TailSamplingProcessor() = default;
+
+std::unique_ptr<trace_sdk::Recordable> TailSamplingProcessor::MakeRecordable() noexcept {
+    return std::make_unique<TailRecordable>(delegate_->MakeRecordable());
+}
+
+void TailSamplingProcessor::OnStart(trace_sdk::Recordable& span,
+                                    const trace_api::SpanContext& parent_context) noexcept {
+    // Every recordable passed in here came from MakeRecordable()
+    auto& tail = static_cast<TailRecordable&>(span);
+    tail.is_root = !parent_context.IsValid() || parent_context.IsRemote();
+    delegate_->OnStart(*tail.inner, parent_context);
+}
+
+void TailSamplingProcessor::OnEnd(std::unique_ptr<trace_sdk::Recordable>&& span) noexcept {
+    std::unique_ptr<TailRecordable> tail(static_cast<TailRecordable*>(span.release()));
+    const TraceKey key = tail->trace_id;
+    const bool is_root = tail->is_root;
+    const bool error = tail->error;
+    const auto duration = tail->duration;
+
+    Decided kept;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto now = Clock::now();
+
+        // Settle traces that waited out the window, and the oldest ones while over capacity
+        while (!arrival_order_.empty() &&
+               (now - arrival_order_.front().second >= options_.window ||
+                buffered_spans_ >= options_.max_spans)) {
+            auto [oldest, first_seen] = arrival_order_.front();
+            arrival_order_.pop_front();
+            auto it = pending_.find(oldest);
+            if (it != pending_.end() && it->second.first_seen == first_seen) {
+                DecideLocked(oldest, KeepOrphan(oldest, it->second), kept);
+            }
+        }
+
+        auto [it, inserted] = pending_.try_emplace(key);
+        PendingTrace& trace = it->second;
+        if (inserted) {
+            trace.first_seen = now;
+            arrival_order_.emplace_back(key, now);
+        }
+        trace.has_error |= error;
+        trace.spans.push_back(std::move(tail));
+        buffered_spans_++;
+
+        if (is_root) {
+            const bool slow = IsSlowLocked(duration);
+            const bool keep = trace.has_error || slow ||
+                              TraceIdRatioSampled(key.data(), options_.keep_ratio);
+            DecideLocked(key, keep, kept);
+        }
+    }
+
+    // The delegate is thread-safe; hand it the kept spans without holding our lock
+    Forward(kept);
+}
+
+bool TailSamplingProcessor::ForceFlush(std::chrono::microseconds timeout) noexcept {
+    DrainAll();
+    return delegate_->ForceFlush(timeout);
+}
+
+bool TailSamplingProcessor::Shutdown(std::chrono::microseconds timeout) noexcept {
+    DrainAll();
+    return delegate_->Shutdown(timeout);
+}
+
+void TailSamplingProcessor::DecideLocked(const TraceKey& key, bool keep, Decided& kept) {
+    auto it = pending_.find(key);
+    if (it == pending_.end()) return;
+
+    buffered_spans_ -= it->second.spans.size();
+    if (keep) {
+        for (auto& span : it->second.spans) kept.push_back(std::move(span));
+    }
+    pending_.erase(it);
+}
+
+bool TailSamplingProcessor::KeepOrphan(const TraceKey& key, const PendingTrace& trace) const {
+    return trace.has_error || TraceIdRatioSampled(key.data(), options_.keep_ratio);
+}
+
+bool TailSamplingProcessor::IsSlowLocked(std::chrono::nanoseconds duration) {
+    if (options_.latency_percentile <= 0.0) return false;
+
+    // Compare with the roots seen so far, then add this one
+    const int64_t nanos = duration.count();
+    const bool slow = latency_threshold_ != 0 && nanos > latency_threshold_;
+
+    if (latencies_.size() < kLatencySamples) {
+        latencies_.push_back(nanos);
+    } else {
+        latencies_[latency_pos_] = nanos;
+        latency_pos_ = (latency_pos_ + 1) % kLatencySamples;
+    }
+
+    if (latencies_.size() >= kLatencyMinSamples &&
+        (++since_update_ >= kLatencyUpdateInterval || latency_threshold_ == 0)) {
+        since_update_ = 0;
+        std::vector<int64_t> sorted(latencies_);
+        auto k = static_cast<size_t>(options_.latency_percentile / 100.0 * (sorted.size() - 1));
+        std::nth_element(sorted.begin(), sorted.begin() + k, sorted.end());
+        latency_threshold_ = sorted[k];
+    }
+    return slow;
+}
+
+void TailSamplingProcessor::Forward(Decided& kept) noexcept {
+    for (auto& span : kept) delegate_->OnEnd(std::move(span->inner));
+}
+
+void TailSamplingProcessor::DrainAll() noexcept {
+    Decided kept;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (!pending_.empty()) {
+            auto it = pending_.begin();
+            DecideLocked(it->first, KeepOrphan(it->first, it->second), kept);
+        }
+        arrival_order_.clear();
+    }
+    Forward(kept);
+}
@@ -0,0 +1,90 @@
+// Error-biased tail sampling for service-e traces
+//
+// TailSamplingProcessor sits in front of the batch span processor. It
+// holds finished spans per trace_id until the trace's local root span ends
+// (or the trace has waited out the window), then forwards or drops the
+// whole trace. Traces with any kError span are always kept, and so are
+// traces whose root was slower than a percentile of recent roots. Every
+// other trace is kept at the base ratio. The ratio check uses the low 8
+// bytes of the trace ID, like service-f; both services join the caller's
+// trace from its traceparent, so they make the same decision for an
+// ordinary trace that passes through both.
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "opentelemetry/sdk/trace/processor.h"
+#include "opentelemetry/sdk/trace/recordable.h"
+
+struct TailSamplingOptions {
+    double keep_ratio = 1.0;            // Share of ordinary traces kept; 1.0 disables tail sampling
+    double latency_percentile = 99.0;   // Roots slower than this percentile are kept; 0 disables
+    std::chrono::milliseconds window{2000};  // Longest a trace waits for its root span
+    size_t max_spans = 8192;            // Spans held at once; the oldest traces are decided early beyond it
+};
+
+// True if the trace falls inside ratio (0.0 - 1.0) by its ID alone
+bool TraceIdRatioSampled(const uint8_t* trace_id, double ratio);
+
+class TailSamplingProcessor final : public opentelemetry::sdk::trace::SpanProcessor {
+public:
+    TailSamplingProcessor(std::unique_ptr<opentelemetry::sdk::trace::SpanProcessor> delegate,
+                          const TailSamplingOptions& options);
+    ~TailSamplingProcessor() override;
+
+    std::unique_ptr<opentelemetry::sdk::trace::Recordable> MakeRecordable() noexcept override;
+    void OnStart(opentelemetry::sdk::trace::Recordable& span,
+                 const opentelemetry::trace::SpanContext& parent_context) noexcept override;
+    void OnEnd(std::unique_ptr<opentelemetry::sdk::trace::Recordable>&& span) noexcept override;
+
+    // Decide every buffered trace, then flush or shut down the delegate
+    bool ForceFlush(std::chrono::microseconds timeout) noexcept override;
+    bool Shutdown(std::chrono::microseconds timeout) noexcept override;
+
+private:
+    class TailRecordable;
+
+    using TraceKey = std::array<uint8_t, 16>;
+    using Clock = std::chrono::steady_clock;
+
+    struct TraceKeyHash {
+        size_t operator()(const TraceKey& key) const noexcept;
+    };
+
+    struct PendingTrace {
+        std::vector<std::unique_ptr<TailRecordable>> spans;
+        Clock::time_point first_seen;
+        bool has_error = false;
+    };
+
+    using Decided = std::vector<std::unique_ptr<TailRecordable>>;
+
+    void DecideLocked(const TraceKey& key, bool keep, Decided& kept);
+    bool KeepOrphan(const TraceKey& key, const PendingTrace& trace) const;
+    bool IsSlowLocked(std::chrono::nanoseconds duration);
+    void Forward(Decided& kept) noexcept;
+    void DrainAll() noexcept;
+
+    std::unique_ptr<opentelemetry::sdk::trace::SpanProcessor> delegate_;
+    TailSamplingOptions options_;
+
+    std::mutex mutex_;
+    std::unordered_map<TraceKey, PendingTrace, TraceKeyHash> pending_;
+    std::deque<std::pair<TraceKey, Clock::time_point>> arrival_order_;  // May hold decided traces
+    size_t buffered_spans_ = 0;
+
+    // Recent root durations and the percentile derived from them
+    std::vector<int64_t> latencies_;
+    size_t latency_pos_ = 0;
+    size_t since_update_ = 0;
+    int64_t latency_threshold_ = 0;    // 0 until enough roots were seen
+};
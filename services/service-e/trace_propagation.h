@@ -0,0 +1,75 @@
+// W3C trace context over gRPC metadata for service-e
+//
+// Server spans take the caller's traceparent as their parent, so the
+// parent-based sampler follows the upstream decision and the call joins the
+// caller's trace instead of starting a new one. Outgoing ServiceD calls carry
+// our span's context the same way. Both go through the global propagator set
+// up in InitTracer().
+
+#pragma once
+
+#include <map>
+#include <string>
+
+#include <grpcpp/grpcpp.h>
+
+#include "opentelemetry/context/propagation/global_propagator.h"
+#include "opentelemetry/context/propagation/text_map_propagator.h"
+#include "opentelemetry/nostd/string_view.h"
+#include "opentelemetry/trace/context.h"
+#include "opentelemetry/trace/span_startoptions.h"
+
+// Reads the caller's headers from a server call's metadata
+class ServerMetadataCarrier final : public opentelemetry::context::propagation::TextMapCarrier {
+public:
+    explicit ServerMetadataCarrier(const std::multimap<grpc::string_ref, grpc::string_ref>& metadata)
+        : metadata_(metadata) {}
+
+    opentelemetry::nostd::string_view Get(opentelemetry::nostd::string_view key) const noexcept override {
+        auto it = metadata_.find(grpc::string_ref(key.data(), key.size()));
+        if (it == metadata_.end()) return "";
+        return opentelemetry::nostd::string_view(it->second.data(), it->second.size());
+    }
+
+    void Set(opentelemetry::nostd::string_view, opentelemetry::nostd::string_view) noexcept override {}
+
+private:
+    const std::multimap<grpc::string_ref, grpc::string_ref>& metadata_;
+};
+
+// Writes headers into an outgoing call's metadata; must be used before the call starts
+class ClientMetadataCarrier final : public opentelemetry::context::propagation::TextMapCarrier {
+public:
+    explicit ClientMetadataCarrier(grpc::ClientContext* context) : context_(context) {}
+
+    opentelemetry::nostd::string_view Get(opentelemetry::nostd::string_view) const noexcept override {
+        return "";
+    }
+
+    void Set(opentelemetry::nostd::string_view key, opentelemetry::nostd::string_view value) noexcept override {
+        context_->AddMetadata(std::string(key.data(), key.size()), std::string(value.data(), value.size()));
+    }
+
+private:
+    grpc::ClientContext* context_;
+};
+
+// Start options for a server span: SERVER kind, parented on the caller's
+// context if it sent one (otherwise the span is a new root)
+inline opentelemetry::trace::StartSpanOptions ServerSpanOptions(const grpc::ServerContextBase& context) {
+    ServerMetadataCarrier carrier(context.client_metadata());
+    opentelemetry::context::Context empty;
+    auto propagator = opentelemetry::context::propagation::GlobalTextMapPropagator::GetGlobalPropagator();
+
+    opentelemetry::trace::StartSpanOptions options;
+    options.kind = opentelemetry::trace::SpanKind::kServer;
+    options.parent = propagator->Extract(carrier, empty);
+    return options;
+}
+
+// Send the span in trace_context (see trace_api::SetSpan) as the parent of an outgoing call
+inline void InjectTraceContext(grpc::ClientContext* client, const opentelemetry::context::Context& trace_context) {
+    ClientMetadataCarrier carrier(client);
+    opentelemetry::context::propagation::GlobalTextMapPropagator::GetGlobalPropagator()->Inject(
+        carrier, trace_context);
+}
@@ -0,0 +1,170 @@
+#include "validation_batcher.h"
+
+#include <atomic>
+#include <vector>
+
+#include <grpcpp/alarm.h>
+
+#include "arena_allocator.h"
+#include "trace_propagation.h"
+
+// One outgoing ValidateBatch call. It is released by two parties, the delay
+// alarm's callback and the RPC completion, and deletes itself after both.
+class ValidationBatcher::Batch {
+public:
+    Batch() {
+        request_ = google::protobuf::Arena::CreateMessage<grpcarch::ValidationBatchRequest>(arena_.get());
+        response_ = google::protobuf::Arena::CreateMessage<grpcarch::ValidationBatchResponse>(arena_.get());
+        request_->mutable_metadata()->set_caller_service("service-e");
+    }
+
+    void Add(const grpcarch::ValidationRequest& item, Deadline deadline,
+             const opentelemetry::context::Context& trace_context, Callback done) {
+        if (callbacks_.empty()) InjectTraceContext(&context, trace_context);
+        request_->add_requests()->CopyFrom(item);
+        callbacks_.push_back(std::move(done));
+        if (callbacks_.size() == 1 || deadline > deadline_) deadline_ = deadline;
+    }
+
+    size_t size() const { return callbacks_.size(); }
+    Deadline deadline() const { return deadline_; }
+
+    // Hand every caller its own item's result
+    void Complete(const grpc::Status& status) {
+        const int responses = response_->responses_size();
+        for (size_t i = 0; i < callbacks_.size(); i++) {
+            if (!status.ok()) {
+                callbacks_[i](status);
+            } else if (static_cast<int>(i) >= responses) {
+                callbacks_[i](grpc::Status(grpc::StatusCode::INTERNAL,
+                                           "ValidateBatch returned too few responses"));
+            } else {
+                const auto& item = response_->responses(static_cast<int>(i));
+                if (item.status().success()) {
+                    callbacks_[i](grpc::Status::OK);
+                } else {
+                    callbacks_[i](grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                                               item.status().message()));
+                }
+            }
+        }
+        callbacks_.clear();
+    }
+
+    void Release() {
+        if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+    }
+
+    grpc::Alarm alarm;
+    grpc::ClientContext context;
+    grpcarch::ValidationBatchRequest* request() { return request_; }
+    grpcarch::ValidationBatchResponse* response() { return response_; }
+
+private:
+    std::atomic<int> refs_{2};
+    InlineArena<8192> arena_;
+    grpcarch::ValidationBatchRequest* request_;
+    grpcarch::ValidationBatchResponse* response_;
+    std::vector<Callback> callbacks_;
+    Deadline deadline_ = Deadline::max();
+};
+
+ValidationBatcher::ValidationBatcher(ChannelPool* channels,
+                                     const ValidationBatcherOptions& options)
+    : channels_(channels), options_(options) {}
+
+ValidationBatcher::~ValidationBatcher() {
+    Batch* batch;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        batch = open_batch_;
+        open_batch_ = nullptr;
+    }
+    if (batch) {
+        batch->alarm.Cancel();
+        Send(batch);
+    }
+
+    // Alarm callbacks touch this object; wait until all of them have run
+    std::unique_lock<std::mutex> lock(mutex_);
+    alarms_drained_.wait(lock, [this] { return pending_alarms_ == 0; });
+}
+
+void ValidationBatcher::Validate(const grpcarch::ValidationRequest& request, Deadline deadline,
+                                 const opentelemetry::context::Context& trace_context, Callback done) {
+    if (deadline != Deadline::max() && deadline <= std::chrono::system_clock::now()) {
+        done(grpc::Status(grpc::StatusCode::DEADLINE_EXCEEDED, "No time left for validation"));
+        return;
+    }
+
+    if (options_.max_batch_size <= 1) {
+        // Batching disabled: one ValidateData call per item
+        struct Call {
+            grpc::ClientContext context;
+            grpcarch::ValidationRequest request;
+            grpcarch::ValidationResponse response;
+            Callback done;
+        };
+        auto* call = new Call;
+        call->request.CopyFrom(request);
+        call->done = std::move(done);
+        if (deadline != Deadline::max()) call->context.set_deadline(deadline);
+        InjectTraceContext(&call->context, trace_context);
+        channels_->Next()->async()->ValidateData(&call->context, &call->request, &call->response,
+            [call](grpc::Status status) {
+                call->done(status);
+                delete call;
+            });
+        return;
+    }
+
+    Batch* full = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!open_batch_) {
+            open_batch_ = new Batch;
+            pending_alarms_++;
+            Batch* batch = open_batch_;
+            batch->alarm.Set(std::chrono::system_clock::now() + options_.max_delay,
+                             [this, batch](bool ok) { OnDelayElapsed(batch, ok); });
+        }
+
+        open_batch_->Add(request, deadline, trace_context, std::move(done));
+        if (open_batch_->size() >= options_.max_batch_size) {
+            full = open_batch_;
+            open_batch_ = nullptr;
+        }
+    }
+
+    if (full) {
+        // Size limit reached first; the alarm callback still runs (with ok=false)
+        full->alarm.Cancel();
+        Send(full);
+    }
+}
+
+void ValidationBatcher::OnDelayElapsed(Batch* batch, bool ok) {
+    bool send = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (open_batch_ == batch) {
+            open_batch_ = nullptr;
+            send = true;
+        }
+    }
+    if (send) Send(batch);
+
+    batch->Release();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--pending_alarms_ == 0) alarms_drained_.notify_all();
+}
+
+void ValidationBatcher::Send(Batch* batch) {
+    if (batch->deadline() != Deadline::max()) batch->context.set_deadline(batch->deadline());
+    channels_->Next()->async()->ValidateBatch(&batch->context, batch->request(), batch->response(),
+        [batch](grpc::Status status) {
+            batch->Complete(status);
+            batch->Release();
+        });
+}
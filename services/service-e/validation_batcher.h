@@ -0,0 +1,68 @@
+// Micro-batching client for ServiceD validation
+//
+// Validate() queues a request and returns immediately. Queued requests go
+// out as one ValidateBatch call once max_batch_size items are waiting or
+// max_delay has passed since the first of them, and each caller's callback
+// receives its own item's result. A batch size of 1 or less disables
+// batching and sends every request as its own ValidateData call.
+//
+// A batch's call deadline is the latest of its items' deadlines, so no
+// item is cut short by a tighter neighbour; an item whose deadline has
+// already passed fails at once without being queued. A call carries one
+// trace context, so a batch is traced as part of its first item's trace.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+
+#include <grpcpp/grpcpp.h>
+
+#include "opentelemetry/context/context.h"
+
+#include "channel_pool.h"
+#include "services.grpc.pb.h"
+
+struct ValidationBatcherOptions {
+    size_t max_batch_size = 32;
+    std::chrono::microseconds max_delay{500};
+};
+
+class ValidationBatcher {
+public:
+    // Receives OK for a valid item, INVALID_ARGUMENT for a rejected one, or
+    // the batch call's own error
+    using Callback = std::function<void(const grpc::Status&)>;
+
+    // Each outgoing call takes the next channel from the pool
+    ValidationBatcher(ChannelPool* channels, const ValidationBatcherOptions& options);
+    ~ValidationBatcher();
+
+    ValidationBatcher(const ValidationBatcher&) = delete;
+    ValidationBatcher& operator=(const ValidationBatcher&) = delete;
+
+    using Deadline = std::chrono::system_clock::time_point;
+
+    // Queue one validation; request is copied, done runs on a gRPC callback
+    // thread. Deadline::max() means the item has no deadline. trace_context
+    // holds the caller's span, which is propagated to ServiceD.
+    void Validate(const grpcarch::ValidationRequest& request, Deadline deadline,
+                  const opentelemetry::context::Context& trace_context, Callback done);
+
+private:
+    class Batch;
+
+    void Send(Batch* batch);
+    void OnDelayElapsed(Batch* batch, bool ok);
+
+    ChannelPool* channels_;
+    ValidationBatcherOptions options_;
+
+    std::mutex mutex_;
+    Batch* open_batch_ = nullptr;   // Batch still accepting items
+    size_t pending_alarms_ = 0;     // Delay alarms whose callback has not run yet
+    std::condition_variable alarms_drained_;
+};
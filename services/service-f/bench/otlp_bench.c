@@ -0,0 +1,201 @@
+/*
+ * Microbenchmarks for service-f's telemetry hot paths
+ *
+ * - Span enqueue (otlp_export_span) and batch encoding (the trace
+ *   exporter's do_export), with the pipeline replaced by a sink that only
+ *   counts the serialized bytes
+ * - Hex encoding/decoding of IDs and traceparent parsing
+ *
+ * The exporter source is included directly so its static export callback
+ * can be driven without a collector. Run `make bench` from the repo root,
+ * or build with the command in the Dockerfile's bench stage.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE
+
+#include "../src/otlp_exporter.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "trace_context.h"
+
+/* Each benchmark runs for at least this long */
+#define MIN_RUN_NANOS 500000000ULL
+#define SPANS_PER_BATCH 512
+
+/* ---- Pipeline sink: everything otlp_exporter.c needs from otlp_pipeline.c ---- */
+
+static char g_sink_signal;
+static uint64_t g_sink_bytes;
+static uint64_t g_sink_requests;
+
+otlp_signal_t* otlp_pipeline_register(otlp_pipeline_t *pipeline, const char *method,
+                                      const char *log_prefix,
+                                      otlp_signal_export_fn export_batch, void *ctx,
+                                      uint32_t schedule_delay_millis,
+                                      uint32_t export_timeout_millis) {
+    (void)pipeline; (void)method; (void)log_prefix; (void)export_batch; (void)ctx;
+    (void)schedule_delay_millis; (void)export_timeout_millis;
+    return (otlp_signal_t*)&g_sink_signal;
+}
+
+void otlp_signal_request_export(otlp_signal_t *signal) {
+    (void)signal;
+}
+
+int otlp_signal_send(otlp_signal_t *signal, grpc_slice request) {
+    (void)signal;
+    g_sink_bytes += GRPC_SLICE_LENGTH(request);
+    g_sink_requests++;
+    grpc_slice_unref(request);
+    return 0;
+}
+
+int otlp_signal_flush(otlp_signal_t *signal, uint32_t timeout_millis) {
+    (void)signal; (void)timeout_millis;
+    return 0;
+}
+
+void otlp_pipeline_unregister(otlp_signal_t *signal) {
+    (void)signal;
+}
+
+/* ---- Harness ---- */
+
+static uint64_t now_nanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void report(const char *name, uint64_t ops, uint64_t nanos, uint64_t bytes) {
+    double ns_per_op = (double)nanos / (double)ops;
+    printf("%-32s %12.1f ns/op %14.0f ops/s", name, ns_per_op, 1e9 / ns_per_op);
+    if (bytes > 0) printf(" %10.1f MB/s", (double)bytes / ((double)nanos / 1e9) / 1e6);
+    printf("\n");
+}
+
+/* Keeps results observable so the compiler cannot drop the work */
+static volatile uint64_t g_sink_value;
+
+/* A server span shaped like FetchLegacyData's */
+static void make_span(otlp_span_t *span, span_attribute_t *attrs, uint8_t *trace_id,
+                      uint8_t *span_id, uint8_t *parent_id, uint64_t i) {
+    memset(trace_id, 0xab, OTLP_TRACE_ID_SIZE);
+    memcpy(trace_id + OTLP_TRACE_ID_SIZE - sizeof(i), &i, sizeof(i));
+    memset(span_id, 0xcd, OTLP_SPAN_ID_SIZE);
+    memset(parent_id, 0xef, OTLP_SPAN_ID_SIZE);
+
+    attrs[0].key = "rpc.system";
+    attrs[0].string_value = "grpc";
+    attrs[1].key = "rpc.service";
+    attrs[1].string_value = "grpcarch.ServiceF";
+    attrs[2].key = "rpc.method";
+    attrs[2].string_value = "FetchLegacyData";
+    attrs[3].key = "db.table";
+    attrs[3].string_value = "legacy_records";
+
+    memset(span, 0, sizeof(*span));
+    span->trace_id = trace_id;
+    span->span_id = span_id;
+    span->parent_span_id = parent_id;
+    span->name = "FetchLegacyData";
+    span->kind = SPAN_KIND_SERVER;
+    span->start_time_nanos = 1700000000000000000ULL + i * 1000;
+    span->end_time_nanos = span->start_time_nanos + 5000000;
+    span->status_code = SPAN_STATUS_OK;
+    span->attributes = attrs;
+    span->attribute_count = 4;
+}
+
+static void bench_span_export(void) {
+    /* Batches larger than the default 512 would be split; keep them whole */
+    setenv("OTEL_BSP_MAX_EXPORT_BATCH_SIZE", "512", 0);
+    setenv("OTEL_BSP_MAX_QUEUE_SIZE", "2048", 0);
+
+    otlp_exporter_t *exporter = otlp_exporter_create((otlp_pipeline_t*)&g_sink_signal, "service-f");
+    if (!exporter) {
+        fprintf(stderr, "[bench] Failed to create exporter\n");
+        exit(1);
+    }
+
+    otlp_span_t span;
+    span_attribute_t attrs[4];
+    uint8_t trace_id[OTLP_TRACE_ID_SIZE], span_id[OTLP_SPAN_ID_SIZE], parent_id[OTLP_SPAN_ID_SIZE];
+
+    uint64_t enqueue_nanos = 0, encode_nanos = 0, spans = 0;
+    uint64_t start = now_nanos();
+    while (now_nanos() - start < MIN_RUN_NANOS) {
+        uint64_t t0 = now_nanos();
+        for (int i = 0; i < SPANS_PER_BATCH; i++) {
+            make_span(&span, attrs, trace_id, span_id, parent_id, spans + i);
+            otlp_export_span(exporter, &span);
+        }
+        uint64_t t1 = now_nanos();
+        while (export_next_batch(exporter) > 0) {}
+        uint64_t t2 = now_nanos();
+
+        enqueue_nanos += t1 - t0;
+        encode_nanos += t2 - t1;
+        spans += SPANS_PER_BATCH;
+    }
+
+    report("otlp_export_span (enqueue)", spans, enqueue_nanos, 0);
+    report("do_export (encode, per span)", spans, encode_nanos, g_sink_bytes);
+    printf("%-32s %12.1f bytes/span, %llu requests\n", "", (double)g_sink_bytes / (double)spans,
+           (unsigned long long)g_sink_requests);
+
+    otlp_exporter_destroy(exporter);
+}
+
+static void bench_hex(void) {
+    uint8_t id[OTLP_TRACE_ID_SIZE];
+    char hex[OTLP_TRACE_ID_HEX_SIZE];
+    for (size_t i = 0; i < sizeof(id); i++) id[i] = (uint8_t)(i * 37 + 11);
+
+    uint64_t ops = 0, start = now_nanos(), elapsed;
+    do {
+        for (int i = 0; i < 1024; i++) {
+            id[0] = (uint8_t)i;
+            hex_encode(id, OTLP_TRACE_ID_SIZE, hex);
+            g_sink_value += (uint8_t)hex[1];
+        }
+        ops += 1024;
+    } while ((elapsed = now_nanos() - start) < MIN_RUN_NANOS);
+    report("hex_encode (trace id)", ops, elapsed, 0);
+
+    ops = 0;
+    start = now_nanos();
+    do {
+        for (int i = 0; i < 1024; i++) {
+            hex[0] = "0123456789abcdef"[i & 15];
+            g_sink_value += (uint64_t)hex_decode(hex, id, OTLP_TRACE_ID_SIZE) + id[0];
+        }
+        ops += 1024;
+    } while ((elapsed = now_nanos() - start) < MIN_RUN_NANOS);
+    report("hex_decode (trace id)", ops, elapsed, 0);
+
+    static const char traceparent[] = "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01";
+    uint8_t span_id[OTLP_SPAN_ID_SIZE];
+    uint8_t flags;
+    ops = 0;
+    start = now_nanos();
+    do {
+        for (int i = 0; i < 1024; i++) {
+            g_sink_value += (uint64_t)trace_context_parse_traceparent(
+                traceparent, sizeof(traceparent) - 1, id, span_id, &flags) + id[i & 15];
+        }
+        ops += 1024;
+    } while ((elapsed = now_nanos() - start) < MIN_RUN_NANOS);
+    report("trace_context_parse_traceparent", ops, elapsed, 0);
+}
+
+int main(void) {
+    bench_span_export();
+    bench_hex();
+    return 0;
+}
@@ -0,0 +1,119 @@
+/*
+ * Bump/arena allocator
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE
+
+#include "arena.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_ALIGNMENT 16
+
+struct arena_block {
+    arena_block_t *next;
+    size_t size;
+    size_t used;
+    _Alignas(ARENA_ALIGNMENT) unsigned char data[];
+};
+
+static inline size_t align_up(size_t n) {
+    return (n + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+}
+
+static arena_block_t* block_create(size_t size) {
+    arena_block_t *block = malloc(sizeof(arena_block_t) + size);
+    if (!block) return NULL;
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+void arena_init(arena_t *arena, size_t initial_size) {
+    arena->blocks = NULL;
+    arena->block_size = initial_size ? align_up(initial_size) : 4096;
+    arena->reserved = 0;
+}
+
+void* arena_alloc(arena_t *arena, size_t size) {
+    size = align_up(size ? size : 1);
+
+    arena_block_t *block = arena->blocks;
+    if (!block || block->size - block->used < size) {
+        /* Grow geometrically so a batch needs O(log n) blocks at most */
+        size_t block_size = arena->block_size;
+        while (block_size < size) block_size *= 2;
+
+        block = block_create(block_size);
+        if (!block) return NULL;
+        block->next = arena->blocks;
+        arena->blocks = block;
+        arena->block_size = block_size * 2;
+    }
+
+    void *ptr = block->data + block->used;
+    block->used += size;
+    arena->reserved += size;
+    return ptr;
+}
+
+void* arena_calloc(arena_t *arena, size_t count, size_t size) {
+    if (size != 0 && count > SIZE_MAX / size) return NULL;
+    void *ptr = arena_alloc(arena, count * size);
+    if (ptr) memset(ptr, 0, count * size);
+    return ptr;
+}
+
+void arena_reset(arena_t *arena) {
+    arena_block_t *block = arena->blocks;
+    if (!block) return;
+
+    if (block->next == NULL) {
+        /* Common case: everything fit in one block */
+        block->used = 0;
+    } else {
+        /* Replace the chain with one block big enough for the high-water mark */
+        size_t high_water = align_up(arena->reserved);
+        while (block) {
+            arena_block_t *next = block->next;
+            free(block);
+            block = next;
+        }
+        arena->blocks = block_create(high_water);
+        arena->block_size = high_water;
+    }
+
+    arena->reserved = 0;
+}
+
+void arena_destroy(arena_t *arena) {
+    arena_block_t *block = arena->blocks;
+    while (block) {
+        arena_block_t *next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->blocks = NULL;
+    arena->reserved = 0;
+}
+
+static void* protobuf_arena_alloc(void *allocator_data, size_t size) {
+    return arena_alloc((arena_t*)allocator_data, size);
+}
+
+static void protobuf_arena_free(void *allocator_data, void *pointer) {
+    /* Reclaimed wholesale by arena_reset() */
+    (void)allocator_data;
+    (void)pointer;
+}
+
+ProtobufCAllocator arena_protobuf_allocator(arena_t *arena) {
+    ProtobufCAllocator allocator;
+    allocator.alloc = protobuf_arena_alloc;
+    allocator.free = protobuf_arena_free;
+    allocator.allocator_data = arena;
+    return allocator;
+}
@@ -0,0 +1,345 @@
+/*
+ * Asynchronous logging - ring producers, batching writer thread
+ *
+ * Producers take the wall-clock time, format into a reserved ring slot and
+ * commit it. The writer copies up to WRITER_BATCH slots out of the ring so
+ * producers get them back immediately, writes the batch with a single
+ * writev() and then feeds the records to the OTLP log exporter, whose
+ * allocations and mutex are now off the request path.
+ *
+ * An idle writer blocks until a producer commits into the empty ring. It
+ * raises g_writer_sleeping before its last look at the ring, and the
+ * producer that finds the flag set clears it and signals. So only the
+ * first record after an idle spell takes the mutex, and no record waits
+ * for a timeout.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE
+
+#include "async_log.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "mpsc_ring.h"
+#include "trace_context.h"
+
+#define DEFAULT_QUEUE_SIZE 4096
+#define WRITER_BATCH 128
+
+/* " | trace_id=<32 hex> span_id=<16 hex>\n" */
+#define SUFFIX_SIZE 80
+
+/* One queued record; fixed size so it fits a ring slot */
+typedef struct {
+    uint64_t timestamp_nanos;
+    log_severity_t severity;
+    uint8_t has_trace_id;
+    uint8_t has_span_id;
+    uint16_t length;
+    uint8_t trace_id[OTLP_TRACE_ID_SIZE];
+    uint8_t span_id[OTLP_SPAN_ID_SIZE];
+    char message[ASYNC_LOG_MESSAGE_SIZE];
+} log_slot_t;
+
+atomic_int async_log_min_severity = LOG_SEVERITY_INFO;
+
+static mpsc_ring_t *g_ring = NULL;          /* NULL while stopped: log synchronously */
+static atomic_size_t g_dropped;
+static otlp_log_exporter_t *g_exporter = NULL;
+static const char *g_service_name = NULL;
+
+static pthread_t g_writer;
+static atomic_int g_running;
+static pthread_mutex_t g_wake_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_wake = PTHREAD_COND_INITIALIZER;
+static atomic_int g_writer_sleeping;       /* Writer found the ring empty and is about to wait */
+
+/* Writer-only copy of the batch being written */
+static log_slot_t g_batch[WRITER_BATCH];
+
+static const char* severity_prefix(log_severity_t severity) {
+    switch (severity) {
+        case LOG_SEVERITY_TRACE: return "[TRACE] ";
+        case LOG_SEVERITY_DEBUG: return "[DEBUG] ";
+        case LOG_SEVERITY_INFO: return "[INFO] ";
+        case LOG_SEVERITY_WARN: return "[WARN] ";
+        case LOG_SEVERITY_ERROR: return "[ERROR] ";
+        case LOG_SEVERITY_FATAL: return "[FATAL] ";
+        default: return "[INFO] ";
+    }
+}
+
+static uint64_t monotonic_nanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* writev() the whole vector, resuming after partial writes */
+static void write_all(struct iovec *iov, int count) {
+    while (count > 0) {
+        ssize_t written = writev(STDOUT_FILENO, iov, count);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        while (count > 0 && (size_t)written >= iov->iov_len) {
+            written -= (ssize_t)iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char*)iov->iov_base + written;
+            iov->iov_len -= (size_t)written;
+        }
+    }
+}
+
+/* Write records as "[LEVEL] message | trace_id=... span_id=..." lines */
+static void write_records(const log_slot_t *records, size_t count) {
+    struct iovec iov[WRITER_BATCH * 3];
+    char suffix[WRITER_BATCH][SUFFIX_SIZE];
+    int iov_count = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        const log_slot_t *record = &records[i];
+        char trace_hex[OTLP_TRACE_ID_HEX_SIZE] = "";
+        char span_hex[OTLP_SPAN_ID_HEX_SIZE] = "";
+        if (record->has_trace_id) hex_encode(record->trace_id, OTLP_TRACE_ID_SIZE, trace_hex);
+        if (record->has_span_id) hex_encode(record->span_id, OTLP_SPAN_ID_SIZE, span_hex);
+        int suffix_len = snprintf(suffix[i], SUFFIX_SIZE, " | trace_id=%s span_id=%s\n",
+                                  trace_hex, span_hex);
+
+        const char *prefix = severity_prefix(record->severity);
+        iov[iov_count].iov_base = (void*)prefix;
+        iov[iov_count++].iov_len = strlen(prefix);
+        iov[iov_count].iov_base = (void*)record->message;
+        iov[iov_count++].iov_len = record->length;
+        iov[iov_count].iov_base = suffix[i];
+        iov[iov_count++].iov_len = (size_t)suffix_len;
+    }
+
+    /* Keep ordering with anything printed through stdio */
+    fflush(stdout);
+    write_all(iov, iov_count);
+}
+
+static void export_records(const log_slot_t *records, size_t count) {
+    if (!g_exporter) return;
+
+    log_attribute_t attrs[1];
+    attrs[0].key = "service.name";
+    attrs[0].string_value = g_service_name;
+
+    for (size_t i = 0; i < count; i++) {
+        otlp_log_record_t record = {0};
+        record.trace_id = records[i].has_trace_id ? records[i].trace_id : NULL;
+        record.span_id = records[i].has_span_id ? records[i].span_id : NULL;
+        record.severity = records[i].severity;
+        record.body = records[i].message;
+        record.timestamp_nanos = records[i].timestamp_nanos;
+        record.attributes = attrs;
+        record.attribute_count = 1;
+        otlp_export_log(g_exporter, &record);
+    }
+}
+
+/* Copy up to one batch out of the ring */
+static size_t drain_batch(void) {
+    size_t count = 0;
+    log_slot_t *slot;
+    while (count < WRITER_BATCH && (slot = mpsc_ring_peek(g_ring)) != NULL) {
+        memcpy(&g_batch[count++], slot, sizeof(log_slot_t));
+        mpsc_ring_release(g_ring);
+    }
+    return count;
+}
+
+static void* writer_thread_func(void *arg) {
+    (void)arg;
+
+    for (;;) {
+        /* Read the flag first so the final drain sees every committed record */
+        int running = atomic_load_explicit(&g_running, memory_order_acquire);
+
+        size_t count = drain_batch();
+        if (count > 0) {
+            write_records(g_batch, count);
+            export_records(g_batch, count);
+            continue;
+        }
+
+        size_t dropped = atomic_exchange_explicit(&g_dropped, 0, memory_order_relaxed);
+        if (dropped > 0) {
+            fprintf(stderr, "[Service F] Log queue full, dropped %zu records\n", dropped);
+        }
+
+        if (!running) break;
+
+        /*
+         * Idle: announce the sleep, then look once more. Pairs with the fence
+         * in async_log_write(): either we see its record or it sees the flag.
+         */
+        atomic_store_explicit(&g_writer_sleeping, 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (mpsc_ring_peek(g_ring) != NULL || !atomic_load_explicit(&g_running, memory_order_relaxed)) {
+            atomic_store_explicit(&g_writer_sleeping, 0, memory_order_relaxed);
+            continue;
+        }
+
+        pthread_mutex_lock(&g_wake_mutex);
+        while (atomic_load_explicit(&g_writer_sleeping, memory_order_relaxed)) {
+            pthread_cond_wait(&g_wake, &g_wake_mutex);
+        }
+        pthread_mutex_unlock(&g_wake_mutex);
+    }
+
+    return NULL;
+}
+
+static log_severity_t parse_level(const char *value, log_severity_t default_value) {
+    if (!value || !*value) return default_value;
+    if (strcasecmp(value, "TRACE") == 0) return LOG_SEVERITY_TRACE;
+    if (strcasecmp(value, "DEBUG") == 0) return LOG_SEVERITY_DEBUG;
+    if (strcasecmp(value, "INFO") == 0) return LOG_SEVERITY_INFO;
+    if (strcasecmp(value, "WARN") == 0 || strcasecmp(value, "WARNING") == 0) return LOG_SEVERITY_WARN;
+    if (strcasecmp(value, "ERROR") == 0) return LOG_SEVERITY_ERROR;
+    if (strcasecmp(value, "FATAL") == 0) return LOG_SEVERITY_FATAL;
+    fprintf(stderr, "[Service F] Ignoring invalid SERVICE_F_LOG_LEVEL=%s\n", value);
+    return default_value;
+}
+
+int async_log_start(otlp_log_exporter_t *exporter, const char *service_name) {
+    if (g_ring) return 0;
+
+    atomic_store(&async_log_min_severity,
+                 (int)parse_level(getenv("SERVICE_F_LOG_LEVEL"), LOG_SEVERITY_INFO));
+
+    size_t capacity = DEFAULT_QUEUE_SIZE;
+    const char *value = getenv("SERVICE_F_LOG_QUEUE_SIZE");
+    if (value && *value) {
+        char *end;
+        unsigned long parsed = strtoul(value, &end, 10);
+        if (*end == '\0' && parsed > 0) {
+            capacity = parsed;
+        } else {
+            fprintf(stderr, "[Service F] Ignoring invalid SERVICE_F_LOG_QUEUE_SIZE=%s\n", value);
+        }
+    }
+
+    mpsc_ring_t *ring = mpsc_ring_create(sizeof(log_slot_t), capacity);
+    if (!ring) {
+        fprintf(stderr, "[Service F] Failed to allocate log queue\n");
+        return -1;
+    }
+
+    g_exporter = exporter;
+    g_service_name = service_name;
+    atomic_store(&g_dropped, 0);
+    atomic_store(&g_writer_sleeping, 0);
+    atomic_store(&g_running, 1);
+    g_ring = ring;
+
+    if (pthread_create(&g_writer, NULL, writer_thread_func, NULL) != 0) {
+        fprintf(stderr, "[Service F] Failed to start log writer thread\n");
+        g_ring = NULL;
+        mpsc_ring_destroy(ring);
+        return -1;
+    }
+    return 0;
+}
+
+void async_log_stop(void) {
+    if (!g_ring) return;
+
+    atomic_store_explicit(&g_running, 0, memory_order_release);
+    atomic_thread_fence(memory_order_seq_cst);
+    pthread_mutex_lock(&g_wake_mutex);
+    atomic_store_explicit(&g_writer_sleeping, 0, memory_order_relaxed);
+    pthread_cond_signal(&g_wake);
+    pthread_mutex_unlock(&g_wake_mutex);
+    pthread_join(g_writer, NULL);
+
+    mpsc_ring_t *ring = g_ring;
+    g_ring = NULL;
+    mpsc_ring_destroy(ring);
+    g_exporter = NULL;
+}
+
+void async_log_write(log_severity_t severity, const uint8_t *trace_id, const uint8_t *span_id,
+                     const char *format, ...) {
+    mpsc_ring_t *ring = g_ring;
+    log_slot_t local;
+    log_slot_t *slot = &local;
+
+    if (ring) {
+        slot = mpsc_ring_reserve(ring);
+        if (!slot) {
+            atomic_fetch_add_explicit(&g_dropped, 1, memory_order_relaxed);
+            return;
+        }
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    slot->timestamp_nanos = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+    slot->severity = severity;
+    slot->has_trace_id = trace_id != NULL;
+    slot->has_span_id = span_id != NULL;
+    if (trace_id) memcpy(slot->trace_id, trace_id, OTLP_TRACE_ID_SIZE);
+    if (span_id) memcpy(slot->span_id, span_id, OTLP_SPAN_ID_SIZE);
+
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(slot->message, sizeof(slot->message), format, args);
+    va_end(args);
+    if (len < 0) len = 0;
+    if ((size_t)len >= sizeof(slot->message)) len = (int)sizeof(slot->message) - 1;
+    slot->length = (uint16_t)len;
+
+    if (!ring) {
+        write_records(slot, 1);
+        return;
+    }
+
+    mpsc_ring_commit(ring, slot);
+
+    /* Wake the writer if it went idle; while it is busy this costs one load */
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&g_writer_sleeping, memory_order_relaxed) &&
+        atomic_exchange_explicit(&g_writer_sleeping, 0, memory_order_relaxed)) {
+        pthread_mutex_lock(&g_wake_mutex);
+        pthread_cond_signal(&g_wake);
+        pthread_mutex_unlock(&g_wake_mutex);
+    }
+}
+
+int async_log_limiter_allow(async_log_limiter_t *limiter, unsigned per_second, unsigned *suppressed) {
+    uint64_t now = monotonic_nanos();
+    uint64_t window_start = atomic_load_explicit(&limiter->window_start_nanos, memory_order_relaxed);
+
+    *suppressed = 0;
+    if (now - window_start >= 1000000000ULL &&
+        atomic_compare_exchange_strong_explicit(&limiter->window_start_nanos, &window_start, now,
+                                                memory_order_relaxed, memory_order_relaxed)) {
+        /* This thread opened the window; concurrent callers may slip one in early */
+        atomic_store_explicit(&limiter->count, 0, memory_order_relaxed);
+        *suppressed = atomic_exchange_explicit(&limiter->suppressed, 0, memory_order_relaxed);
+    }
+
+    if (atomic_fetch_add_explicit(&limiter->count, 1, memory_order_relaxed) < per_second) {
+        return 1;
+    }
+    atomic_fetch_add_explicit(&limiter->suppressed, 1, memory_order_relaxed);
+    return 0;
+}
@@ -0,0 +1,129 @@
+/*
+ * Asynchronous logging for the request path
+ *
+ * Producers format straight into a fixed-size slot of a lock-free ring
+ * (mpsc_ring) and return; no locks, allocations or syscalls. A background
+ * writer drains the ring in batches, writes the lines to stdout with one
+ * writev() per batch and hands each record to the OTLP log exporter.
+ *
+ * Records below the threshold are skipped before any formatting. The
+ * threshold is checked twice: against SERVICE_F_LOG_MIN_SEVERITY at compile
+ * time (-DSERVICE_F_LOG_MIN_SEVERITY=LOG_SEVERITY_WARN removes the call
+ * entirely), then against the runtime level from SERVICE_F_LOG_LEVEL.
+ *
+ * Environment:
+ *   SERVICE_F_LOG_LEVEL        TRACE, DEBUG, INFO (default), WARN, ERROR
+ *   SERVICE_F_LOG_QUEUE_SIZE   Ring capacity in records (default: 4096)
+ */
+
+#ifndef ASYNC_LOG_H
+#define ASYNC_LOG_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "otlp_log_exporter.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Messages longer than this are truncated */
+#define ASYNC_LOG_MESSAGE_SIZE 256
+
+#ifndef SERVICE_F_LOG_MIN_SEVERITY
+#define SERVICE_F_LOG_MIN_SEVERITY LOG_SEVERITY_TRACE
+#endif
+
+/* Runtime threshold; use async_log_enabled() rather than reading it directly */
+extern atomic_int async_log_min_severity;
+
+/* Per-call-site limiter for LOG_RATE_LIMITED(); zero-initialized */
+typedef struct {
+    _Atomic uint64_t window_start_nanos;
+    atomic_uint count;
+    atomic_uint suppressed;
+} async_log_limiter_t;
+
+/*
+ * Start the writer thread; call before any request thread logs
+ *
+ * Records logged before this are written synchronously to stdout.
+ *
+ * @param exporter      OTLP log exporter to feed, or NULL for stdout only
+ * @param service_name  Value of the service.name attribute on exported records
+ * @return  0 on success, -1 on failure
+ */
+int async_log_start(otlp_log_exporter_t *exporter, const char *service_name);
+
+/*
+ * Drain the queue and stop the writer thread; call once the request threads
+ * have stopped and before destroying the exporter. Later records are
+ * written synchronously.
+ */
+void async_log_stop(void);
+
+/*
+ * Whether a record at this severity passes the runtime threshold
+ *
+ * @param severity  Record severity
+ * @return  Non-zero if the record should be formatted
+ */
+static inline int async_log_enabled(log_severity_t severity) {
+    return (int)severity >= atomic_load_explicit(&async_log_min_severity, memory_order_relaxed);
+}
+
+/*
+ * Format a record into the queue (any thread)
+ *
+ * Drops the record, counting it, if the queue is full. Prefer the LOG_AT()
+ * and LOG_RATE_LIMITED() macros, which skip filtered records before the
+ * arguments are evaluated.
+ *
+ * @param severity  Record severity
+ * @param trace_id  OTLP_TRACE_ID_SIZE bytes, or NULL
+ * @param span_id   OTLP_SPAN_ID_SIZE bytes, or NULL
+ * @param format    printf-style format
+ */
+void async_log_write(log_severity_t severity, const uint8_t *trace_id, const uint8_t *span_id,
+                     const char *format, ...) __attribute__((format(printf, 4, 5)));
+
+/*
+ * Take one token from a call-site limiter
+ *
+ * @param limiter     Call-site limiter
+ * @param per_second  Records allowed per one-second window
+ * @param suppressed  Receives the number of records dropped since the
+ *                    previous window when this call opens a new one, else 0
+ * @return  Non-zero if the record may be logged
+ */
+int async_log_limiter_allow(async_log_limiter_t *limiter, unsigned per_second, unsigned *suppressed);
+
+/* Log if severity passes both thresholds */
+#define LOG_AT(severity, trace_id, span_id, ...)                                     \
+    do {                                                                             \
+        if ((severity) >= SERVICE_F_LOG_MIN_SEVERITY && async_log_enabled(severity)) \
+            async_log_write((severity), (trace_id), (span_id), __VA_ARGS__);         \
+    } while (0)
+
+/* LOG_AT() limited to per_second records per second at this call site */
+#define LOG_RATE_LIMITED(per_second, severity, trace_id, span_id, ...)                        \
+    do {                                                                                      \
+        static async_log_limiter_t log_limiter_;                                              \
+        unsigned log_suppressed_;                                                             \
+        if ((severity) >= SERVICE_F_LOG_MIN_SEVERITY && async_log_enabled(severity) &&        \
+            async_log_limiter_allow(&log_limiter_, (per_second), &log_suppressed_)) {         \
+            if (log_suppressed_ > 0)                                                          \
+                async_log_write((severity), NULL, NULL,                                       \
+                                "Suppressed %u similar messages since the last one",          \
+                                log_suppressed_);                                             \
+            async_log_write((severity), (trace_id), (span_id), __VA_ARGS__);                  \
+        }                                                                                     \
+    } while (0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ASYNC_LOG_H */
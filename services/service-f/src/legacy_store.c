@@ -0,0 +1,467 @@
+/*
+ * Memory-mapped legacy record store
+ *
+ * The table list and each table's current snapshot pointer are guarded by
+ * a read-write lock that lookups hold only long enough to take a
+ * reference; probing the index and reading the record happen outside it.
+ * Reloads are serialized by their own mutex, so the reload path can read
+ * the table list without the lock and only takes it to publish a swap.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE
+
+#include "legacy_store.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <errno.h>
+#include <endian.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <limits.h>
+
+#define SNAPSHOT_MAGIC "LRSTORE1"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_SUFFIX ".lrs"
+
+/* On-disk header */
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t record_count;
+    uint64_t slot_count;
+    uint64_t index_offset;
+    uint64_t data_offset;
+    uint64_t file_size;
+    uint64_t order_offset;
+} snapshot_header_t;
+
+/* On-disk index slot */
+typedef struct {
+    uint64_t hash;
+    uint64_t record_offset;
+} snapshot_slot_t;
+
+/* On-disk record header, followed by the ID and raw data */
+typedef struct {
+    uint32_t id_len;
+    uint32_t raw_len;
+    int64_t created_at;
+    int64_t updated_at;
+} snapshot_record_t;
+
+/* One mapped snapshot file */
+struct legacy_snapshot {
+    atomic_uint refs;
+    const uint8_t *map;
+    size_t map_len;
+    const snapshot_slot_t *slots;
+    uint64_t slot_mask;
+    uint64_t record_count;
+    const uint64_t *order;          /* NULL without an order index */
+
+    /* File identity, to tell whether the file has been replaced */
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    struct timespec mtime;
+};
+
+typedef struct {
+    char name[LEGACY_STORE_MAX_NAME + 1];
+    legacy_snapshot_t *current;     /* NULL while the file is missing */
+} store_table_t;
+
+struct legacy_store {
+    char *dir;
+
+    pthread_rwlock_t lock;          /* Guards tables[] and table_count */
+    store_table_t tables[LEGACY_STORE_MAX_TABLES];
+    size_t table_count;
+
+    /* Reload thread */
+    pthread_mutex_t reload_mutex;   /* Serializes reloads */
+    pthread_mutex_t wait_mutex;
+    pthread_cond_t wait_cond;
+    pthread_t reload_thread;
+    unsigned reload_seconds;
+    int stopping;                   /* Guarded by wait_mutex */
+};
+
+/* 64-bit FNV-1a; 0 marks an empty slot, so it is never returned */
+static uint64_t record_hash(const char *id, size_t len) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (uint8_t)id[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash ? hash : 1;
+}
+
+static int same_file(const legacy_snapshot_t *snapshot, const struct stat *st) {
+    return snapshot->dev == st->st_dev && snapshot->ino == st->st_ino &&
+           snapshot->size == st->st_size &&
+           snapshot->mtime.tv_sec == st->st_mtim.tv_sec &&
+           snapshot->mtime.tv_nsec == st->st_mtim.tv_nsec;
+}
+
+/* Map and validate a snapshot file; returns it with one reference */
+static legacy_snapshot_t* snapshot_open(const char *path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        fprintf(stderr, "[LEGACY-STORE] Cannot open %s: %s\n", path, strerror(errno));
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(snapshot_header_t)) {
+        fprintf(stderr, "[LEGACY-STORE] %s is not a snapshot\n", path);
+        close(fd);
+        return NULL;
+    }
+
+    size_t map_len = (size_t)st.st_size;
+    void *map = mmap(NULL, map_len, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "[LEGACY-STORE] Cannot map %s: %s\n", path, strerror(errno));
+        return NULL;
+    }
+
+    snapshot_header_t header;
+    memcpy(&header, map, sizeof(header));
+    uint64_t slot_count = le64toh(header.slot_count);
+    uint64_t index_offset = le64toh(header.index_offset);
+    uint64_t record_count = le64toh(header.record_count);
+    uint64_t order_offset = le64toh(header.order_offset);
+
+    int valid = memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) == 0 &&
+                le32toh(header.version) == SNAPSHOT_VERSION &&
+                le64toh(header.file_size) == map_len &&
+                slot_count > 0 && (slot_count & (slot_count - 1)) == 0 &&
+                index_offset % sizeof(uint64_t) == 0 &&
+                index_offset >= sizeof(header) && index_offset <= map_len &&
+                slot_count <= (map_len - index_offset) / sizeof(snapshot_slot_t) &&
+                (order_offset == 0 ||
+                 (order_offset % sizeof(uint64_t) == 0 && order_offset <= map_len &&
+                  record_count <= (map_len - order_offset) / sizeof(uint64_t)));
+    if (!valid) {
+        fprintf(stderr, "[LEGACY-STORE] %s has an invalid header\n", path);
+        munmap(map, map_len);
+        return NULL;
+    }
+
+    legacy_snapshot_t *snapshot = calloc(1, sizeof(legacy_snapshot_t));
+    if (!snapshot) {
+        munmap(map, map_len);
+        return NULL;
+    }
+
+    /* Lookups jump around the file; readahead would only evict useful pages */
+    madvise(map, map_len, MADV_RANDOM);
+
+    atomic_init(&snapshot->refs, 1);
+    snapshot->map = map;
+    snapshot->map_len = map_len;
+    snapshot->slots = (const snapshot_slot_t*)((const uint8_t*)map + index_offset);
+    snapshot->slot_mask = slot_count - 1;
+    snapshot->record_count = record_count;
+    snapshot->order = order_offset ? (const uint64_t*)((const uint8_t*)map + order_offset) : NULL;
+    snapshot->dev = st.st_dev;
+    snapshot->ino = st.st_ino;
+    snapshot->size = st.st_size;
+    snapshot->mtime = st.st_mtim;
+    return snapshot;
+}
+
+void legacy_snapshot_retain(legacy_snapshot_t *snapshot) {
+    atomic_fetch_add_explicit(&snapshot->refs, 1, memory_order_relaxed);
+}
+
+void legacy_snapshot_release(void *ptr) {
+    legacy_snapshot_t *snapshot = (legacy_snapshot_t*)ptr;
+    if (!snapshot) return;
+    if (atomic_fetch_sub_explicit(&snapshot->refs, 1, memory_order_acq_rel) != 1) return;
+
+    munmap((void*)snapshot->map, snapshot->map_len);
+    free(snapshot);
+}
+
+/* Decode the record at offset, bounds-checked against the mapping */
+static int snapshot_record(const legacy_snapshot_t *snapshot, uint64_t offset, legacy_record_t *out) {
+    if (offset > snapshot->map_len || snapshot->map_len - offset < sizeof(snapshot_record_t)) {
+        return -1;
+    }
+
+    snapshot_record_t header;
+    memcpy(&header, snapshot->map + offset, sizeof(header));
+    size_t id_len = le32toh(header.id_len);
+    size_t raw_len = le32toh(header.raw_len);
+    if (id_len + raw_len > snapshot->map_len - offset - sizeof(header)) return -1;
+
+    const uint8_t *data = snapshot->map + offset + sizeof(header);
+    out->id = (const char*)data;
+    out->id_len = id_len;
+    out->raw_data = data + id_len;
+    out->raw_len = raw_len;
+    out->created_at = (int64_t)le64toh((uint64_t)header.created_at);
+    out->updated_at = (int64_t)le64toh((uint64_t)header.updated_at);
+    return 0;
+}
+
+legacy_snapshot_t* legacy_store_acquire(legacy_store_t *store, const char *table) {
+    if (!store || !table) return NULL;
+
+    legacy_snapshot_t *snapshot = NULL;
+    pthread_rwlock_rdlock(&store->lock);
+    for (size_t i = 0; i < store->table_count; i++) {
+        if (strcmp(store->tables[i].name, table) == 0) {
+            snapshot = store->tables[i].current;
+            if (snapshot) legacy_snapshot_retain(snapshot);
+            break;
+        }
+    }
+    pthread_rwlock_unlock(&store->lock);
+    return snapshot;
+}
+
+int legacy_snapshot_find(const legacy_snapshot_t *snapshot, const char *id, size_t id_len,
+                         legacy_record_t *out) {
+    /* Linear probing; the snapshot is immutable, so no lock is needed */
+    uint64_t hash = record_hash(id, id_len);
+    uint64_t slot = hash & snapshot->slot_mask;
+    for (uint64_t probes = 0; probes <= snapshot->slot_mask; probes++) {
+        uint64_t slot_hash = le64toh(snapshot->slots[slot].hash);
+        if (slot_hash == 0) break;
+
+        if (slot_hash == hash &&
+            snapshot_record(snapshot, le64toh(snapshot->slots[slot].record_offset), out) == 0 &&
+            out->id_len == id_len && memcmp(out->id, id, id_len) == 0) {
+            return 0;
+        }
+        slot = (slot + 1) & snapshot->slot_mask;
+    }
+    return -1;
+}
+
+legacy_snapshot_t* legacy_store_lookup(legacy_store_t *store, const char *table,
+                                       const char *id, size_t id_len, legacy_record_t *out) {
+    if (!id) return NULL;
+
+    legacy_snapshot_t *snapshot = legacy_store_acquire(store, table);
+    if (snapshot && legacy_snapshot_find(snapshot, id, id_len, out) != 0) {
+        legacy_snapshot_release(snapshot);
+        return NULL;
+    }
+    return snapshot;
+}
+
+int legacy_record_compare_id(const legacy_record_t *record, const char *id, size_t id_len) {
+    size_t len = record->id_len < id_len ? record->id_len : id_len;
+    int cmp = memcmp(record->id, id, len);
+    if (cmp != 0) return cmp;
+    return (record->id_len > id_len) - (record->id_len < id_len);
+}
+
+int legacy_snapshot_record_at(const legacy_snapshot_t *snapshot, size_t pos, legacy_record_t *out) {
+    if (!snapshot->order || pos >= snapshot->record_count) return -1;
+    return snapshot_record(snapshot, le64toh(snapshot->order[pos]), out);
+}
+
+int legacy_snapshot_seek(const legacy_snapshot_t *snapshot, const char *id, size_t id_len, size_t *pos) {
+    if (!snapshot->order) return -1;
+
+    /* Lower bound; unreadable records sort last so a damaged file cannot loop */
+    size_t lo = 0, hi = snapshot->record_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        legacy_record_t record;
+        if (legacy_snapshot_record_at(snapshot, mid, &record) == 0 &&
+            legacy_record_compare_id(&record, id, id_len) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    *pos = lo;
+    return 0;
+}
+
+/* Publish a table's new snapshot (NULL to unload it) and drop the old one */
+static void swap_snapshot(legacy_store_t *store, store_table_t *table, legacy_snapshot_t *snapshot) {
+    pthread_rwlock_wrlock(&store->lock);
+    legacy_snapshot_t *old = table->current;
+    table->current = snapshot;
+    pthread_rwlock_unlock(&store->lock);
+
+    legacy_snapshot_release(old);
+}
+
+int legacy_store_reload(legacy_store_t *store) {
+    pthread_mutex_lock(&store->reload_mutex);
+
+    DIR *dir = opendir(store->dir);
+    if (!dir) {
+        fprintf(stderr, "[LEGACY-STORE] Cannot read %s: %s\n", store->dir, strerror(errno));
+        pthread_mutex_unlock(&store->reload_mutex);
+        return -1;
+    }
+
+    int seen[LEGACY_STORE_MAX_TABLES] = {0};
+    int changes = 0;
+    size_t suffix_len = strlen(SNAPSHOT_SUFFIX);
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        size_t len = strlen(entry->d_name);
+        if (len <= suffix_len || len - suffix_len > LEGACY_STORE_MAX_NAME ||
+            strcmp(entry->d_name + len - suffix_len, SNAPSHOT_SUFFIX) != 0) {
+            continue;
+        }
+
+        char name[LEGACY_STORE_MAX_NAME + 1];
+        memcpy(name, entry->d_name, len - suffix_len);
+        name[len - suffix_len] = '\0';
+
+        struct stat st;
+        if (fstatat(dirfd(dir), entry->d_name, &st, 0) != 0 || !S_ISREG(st.st_mode)) continue;
+
+        /* Only this function modifies the table list, so it can be read unlocked */
+        size_t index = 0;
+        while (index < store->table_count && strcmp(store->tables[index].name, name) != 0) index++;
+        if (index == LEGACY_STORE_MAX_TABLES) {
+            fprintf(stderr, "[LEGACY-STORE] Too many tables, ignoring %s\n", entry->d_name);
+            continue;
+        }
+        if (index < store->table_count) {
+            seen[index] = 1;
+            if (store->tables[index].current && same_file(store->tables[index].current, &st)) continue;
+        }
+
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s/%s", store->dir, entry->d_name);
+        legacy_snapshot_t *snapshot = snapshot_open(path);
+        if (!snapshot) continue;    /* Keep serving the previous snapshot, if any */
+
+        if (index == store->table_count) {
+            /* New table; entries are never removed, so index stays valid */
+            store_table_t *table = &store->tables[index];
+            memcpy(table->name, name, sizeof(name));
+            table->current = NULL;
+            pthread_rwlock_wrlock(&store->lock);
+            store->table_count++;
+            pthread_rwlock_unlock(&store->lock);
+            seen[index] = 1;
+        }
+        swap_snapshot(store, &store->tables[index], snapshot);
+        printf("[LEGACY-STORE] Loaded table %s: %llu records\n",
+               name, (unsigned long long)snapshot->record_count);
+        changes++;
+    }
+    closedir(dir);
+
+    /* Files that disappeared unload their tables */
+    for (size_t i = 0; i < store->table_count; i++) {
+        if (!seen[i] && store->tables[i].current) {
+            swap_snapshot(store, &store->tables[i], NULL);
+            printf("[LEGACY-STORE] Unloaded table %s\n", store->tables[i].name);
+            changes++;
+        }
+    }
+
+    pthread_mutex_unlock(&store->reload_mutex);
+    return changes;
+}
+
+/* Background thread: rescan the directory every reload_seconds */
+static void* reload_thread_func(void *arg) {
+    legacy_store_t *store = (legacy_store_t*)arg;
+
+    pthread_mutex_lock(&store->wait_mutex);
+    while (!store->stopping) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += store->reload_seconds;
+
+        while (!store->stopping &&
+               pthread_cond_timedwait(&store->wait_cond, &store->wait_mutex, &deadline) != ETIMEDOUT) {
+        }
+        if (store->stopping) break;
+
+        pthread_mutex_unlock(&store->wait_mutex);
+        legacy_store_reload(store);
+        pthread_mutex_lock(&store->wait_mutex);
+    }
+    pthread_mutex_unlock(&store->wait_mutex);
+
+    return NULL;
+}
+
+legacy_store_t* legacy_store_open(const char *dir, unsigned reload_seconds) {
+    if (!dir) return NULL;
+
+    legacy_store_t *store = calloc(1, sizeof(legacy_store_t));
+    if (!store) return NULL;
+
+    store->dir = strdup(dir);
+    store->reload_seconds = reload_seconds;
+    pthread_rwlock_init(&store->lock, NULL);
+    pthread_mutex_init(&store->reload_mutex, NULL);
+    pthread_mutex_init(&store->wait_mutex, NULL);
+
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&store->wait_cond, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+
+    if (!store->dir || legacy_store_reload(store) < 0) {
+        free(store->dir);
+        pthread_rwlock_destroy(&store->lock);
+        pthread_mutex_destroy(&store->reload_mutex);
+        pthread_mutex_destroy(&store->wait_mutex);
+        pthread_cond_destroy(&store->wait_cond);
+        free(store);
+        return NULL;
+    }
+
+    if (reload_seconds > 0 &&
+        pthread_create(&store->reload_thread, NULL, reload_thread_func, store) != 0) {
+        fprintf(stderr, "[LEGACY-STORE] Failed to start reload thread, snapshots stay fixed\n");
+        store->reload_seconds = 0;
+    }
+
+    return store;
+}
+
+void legacy_store_close(legacy_store_t *store) {
+    if (!store) return;
+
+    if (store->reload_seconds > 0) {
+        pthread_mutex_lock(&store->wait_mutex);
+        store->stopping = 1;
+        pthread_cond_signal(&store->wait_cond);
+        pthread_mutex_unlock(&store->wait_mutex);
+        pthread_join(store->reload_thread, NULL);
+    }
+
+    for (size_t i = 0; i < store->table_count; i++) {
+        legacy_snapshot_release(store->tables[i].current);
+    }
+
+    free(store->dir);
+    pthread_rwlock_destroy(&store->lock);
+    pthread_mutex_destroy(&store->reload_mutex);
+    pthread_mutex_destroy(&store->wait_mutex);
+    pthread_cond_destroy(&store->wait_cond);
+    free(store);
+}
@@ -0,0 +1,174 @@
+/*
+ * Memory-mapped legacy record store
+ *
+ * Each table is an immutable snapshot file <table_name>.lrs in the store
+ * directory, mapped read-only. A lookup hashes the record ID into an
+ * open-addressing index at the front of the file and follows the slot to
+ * the record, so it touches two pages of the mapping: the slot and the
+ * record. Raw data is returned as a pointer into the mapping, together with
+ * a reference that keeps the snapshot mapped until the caller releases it.
+ * An optional second index lists the records in ID order for range scans.
+ *
+ * Snapshots are replaced online: write the new file next to the old one
+ * and rename() it into place. A background thread rescans the directory,
+ * maps new and changed files, and swaps them in; calls holding the old
+ * snapshot finish against it, and it is unmapped when the last one releases
+ * it. Removing a file unloads its table.
+ *
+ * File layout (little-endian, see tools/legacy_store/build_snapshot.py):
+ *
+ *   header   magic "LRSTORE1", version, record count, slot count (a power
+ *            of two), index and data offsets, file size, order offset
+ *   index    slot_count x {uint64 hash, uint64 record offset}; hash 0 is empty
+ *   records  {uint32 id_len, uint32 raw_len, int64 created_at,
+ *            int64 updated_at, id bytes, raw bytes}, 8-byte aligned
+ *   order    record_count x uint64 record offset, sorted by ID bytes
+ *            (memcmp order, shorter first); absent when the order offset is 0
+ *
+ * The hash is 64-bit FNV-1a of the record ID, with 0 mapped to 1.
+ */
+
+#ifndef LEGACY_STORE_H
+#define LEGACY_STORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Tables are loaded from at most this many files */
+#define LEGACY_STORE_MAX_TABLES 64
+
+/* Longest table name, excluding the .lrs suffix */
+#define LEGACY_STORE_MAX_NAME 128
+
+typedef struct legacy_store legacy_store_t;
+typedef struct legacy_snapshot legacy_snapshot_t;
+
+/* A record as it sits in the mapping; valid while its snapshot is held */
+typedef struct {
+    const char *id;             /* Not NUL-terminated */
+    size_t id_len;
+    const uint8_t *raw_data;
+    size_t raw_len;
+    int64_t created_at;
+    int64_t updated_at;
+} legacy_record_t;
+
+/*
+ * Load every snapshot in a directory and start the reload thread
+ *
+ * @param dir             Directory holding <table_name>.lrs files
+ * @param reload_seconds  Rescan interval; 0 disables online reloads
+ * @return  Store handle, or NULL on failure
+ */
+legacy_store_t* legacy_store_open(const char *dir, unsigned reload_seconds);
+
+/*
+ * Stop the reload thread and release the store's snapshots; snapshots still
+ * held by callers stay mapped until they are released
+ *
+ * @param store  Store handle
+ */
+void legacy_store_close(legacy_store_t *store);
+
+/*
+ * Rescan the directory now, swapping in new and changed snapshots
+ *
+ * @param store  Store handle
+ * @return  Number of tables loaded, replaced or unloaded, or -1 if the
+ *          directory could not be read
+ */
+int legacy_store_reload(legacy_store_t *store);
+
+/*
+ * Take a reference to a table's current snapshot (any thread)
+ *
+ * @param store  Store handle
+ * @param table  Table name
+ * @return  Snapshot reference, or NULL if the table does not exist
+ */
+legacy_snapshot_t* legacy_store_acquire(legacy_store_t *store, const char *table);
+
+/*
+ * Look up a record (any thread); legacy_store_acquire() followed by
+ * legacy_snapshot_find()
+ *
+ * @param store      Store handle
+ * @param table      Table name
+ * @param id         Record ID
+ * @param id_len     Length of id
+ * @param out        Receives the record
+ * @return  Reference to the snapshot backing out, to be released with
+ *          legacy_snapshot_release(); NULL if the table or record does not exist
+ */
+legacy_snapshot_t* legacy_store_lookup(legacy_store_t *store, const char *table,
+                                       const char *id, size_t id_len, legacy_record_t *out);
+
+/*
+ * Find a record in a snapshot
+ *
+ * @param snapshot  Snapshot reference
+ * @param id        Record ID
+ * @param id_len    Length of id
+ * @param out       Receives the record
+ * @return  0 if found, -1 otherwise
+ */
+int legacy_snapshot_find(const legacy_snapshot_t *snapshot, const char *id, size_t id_len,
+                         legacy_record_t *out);
+
+/*
+ * Position of the first record whose ID is not below id, in ID order
+ *
+ * @param snapshot  Snapshot reference
+ * @param id        Lower bound (an empty ID seeks to the first record)
+ * @param id_len    Length of id
+ * @param pos       Receives the position, record count if every ID is below
+ * @return  0 on success, -1 if the snapshot has no order index
+ */
+int legacy_snapshot_seek(const legacy_snapshot_t *snapshot, const char *id, size_t id_len, size_t *pos);
+
+/*
+ * Record at a position in ID order
+ *
+ * @param snapshot  Snapshot reference
+ * @param pos       Position from legacy_snapshot_seek() or later
+ * @param out       Receives the record
+ * @return  0 on success, -1 past the last record or without an order index
+ */
+int legacy_snapshot_record_at(const legacy_snapshot_t *snapshot, size_t pos, legacy_record_t *out);
+
+/*
+ * Compare a record's ID with another ID in index order
+ *
+ * @param record  Record
+ * @param id      ID to compare with
+ * @param id_len  Length of id
+ * @return  Negative, zero or positive as the record's ID sorts before, equal
+ *          to or after id
+ */
+int legacy_record_compare_id(const legacy_record_t *record, const char *id, size_t id_len);
+
+/*
+ * Take another reference to a snapshot
+ *
+ * @param snapshot  Snapshot reference
+ */
+void legacy_snapshot_retain(legacy_snapshot_t *snapshot);
+
+/*
+ * Drop a reference returned by legacy_store_acquire(), legacy_store_lookup()
+ * or legacy_snapshot_retain(); the argument is void* so this can be a
+ * grpc_slice_new_with_user_data() destroy callback
+ *
+ * @param snapshot  Snapshot reference, or NULL
+ */
+void legacy_snapshot_release(void *snapshot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LEGACY_STORE_H */
@@ -4,7 +4,22 @@
  * This is a pure C implementation using:
  * - gRPC C core library for the gRPC server
  * - protobuf-c for protocol buffer serialization
- * - Manual OTLP exporters for traces, logs, and metrics
+ * - Manual OTLP exporters for traces, logs, and metrics, sharing one
+ *   channel, completion queue and export thread (otlp_pipeline)
+ *
+ * The server runs a pool of worker threads (SERVICE_F_WORKER_THREADS, default:
+ * one per CPU), each driving its own completion queue with
+ * SERVICE_F_PENDING_CALLS pre-posted request slots. Calls are fully
+ * asynchronous: the simulated DB lookup parks the call on a per-worker timer
+ * heap instead of sleeping, so one worker keeps many calls in flight.
+ *
+ * With SERVICE_F_LEGACY_STORE_DIR set, records are served from memory-mapped
+ * snapshot files instead (legacy_store), rescanned for replacements every
+ * SERVICE_F_LEGACY_STORE_RELOAD_SECONDS (default: 5). Besides FetchLegacyData,
+ * the store serves FetchLegacyDataBatch (up to SERVICE_F_MAX_BATCH_RECORDS IDs
+ * per call, default: 1000) and StreamLegacyData, which walks a table's ID
+ * order in messages of about SERVICE_F_STREAM_CHUNK_BYTES (default: 64 KiB).
+ * Large raw_data values are sent from the mapping without being copied.
  */
 
 /* Enable POSIX features for strdup, usleep, etc. */
@@ -25,81 +40,70 @@
 #include <grpc/support/alloc.h>
 #include <grpc/byte_buffer.h>
 #include <grpc/byte_buffer_reader.h>
+#include <grpc/slice.h>
 
 #include "services.pb-c.h"
 #include "common.pb-c.h"
+#include "arena.h"
+#include "rng.h"
+#include "trace_context.h"
+#include "otlp_pipeline.h"
 #include "otlp_exporter.h"
 #include "otlp_log_exporter.h"
 #include "otlp_metrics_exporter.h"
+#include "async_log.h"
+#include "request_metrics.h"
+#include "legacy_store.h"
+#include "record_encoder.h"
 
 /* Server state */
 static grpc_server *g_server = NULL;
 static grpc_completion_queue *g_cq = NULL;
 static int g_shutdown = 0;
+static otlp_pipeline_t *g_otlp_pipeline = NULL;
 static otlp_exporter_t *g_trace_exporter = NULL;
 static otlp_log_exporter_t *g_log_exporter = NULL;
 static otlp_metrics_exporter_t *g_metrics_exporter = NULL;
-static const char *g_service_name = "service-f";
-
-/* Metrics state */
-static pthread_mutex_t g_metrics_mutex = PTHREAD_MUTEX_INITIALIZER;
-static uint64_t g_request_count = 0;
-static double g_total_duration_ms = 0;
-static pthread_t g_metrics_thread;
-
-/* Log with OTLP export */
-static void log_otlp(log_severity_t severity, const char *trace_id, const char *span_id,
-                     const char *message) {
-    struct timespec ts;
-    clock_gettime(CLOCK_REALTIME, &ts);
-    uint64_t timestamp_nanos = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
-
-    /* Also print to stdout for debugging */
-    const char *level_str;
-    switch (severity) {
-        case LOG_SEVERITY_DEBUG: level_str = "DEBUG"; break;
-        case LOG_SEVERITY_INFO: level_str = "INFO"; break;
-        case LOG_SEVERITY_WARN: level_str = "WARN"; break;
-        case LOG_SEVERITY_ERROR: level_str = "ERROR"; break;
-        case LOG_SEVERITY_FATAL: level_str = "FATAL"; break;
-        default: level_str = "INFO"; break;
-    }
-    printf("[%s] %s | trace_id=%s span_id=%s\n", level_str, message,
-           trace_id ? trace_id : "", span_id ? span_id : "");
-    fflush(stdout);
-
-    /* Export to OTLP if exporter is available */
-    if (g_log_exporter) {
-        otlp_log_record_t record = {0};
-        record.trace_id = trace_id;
-        record.span_id = span_id;
-        record.severity = severity;
-        record.body = message;
-        record.timestamp_nanos = timestamp_nanos;
-
-        /* Add service attribute */
-        log_attribute_t attrs[1];
-        attrs[0].key = "service.name";
-        attrs[0].string_value = g_service_name;
-        record.attributes = attrs;
-        record.attribute_count = 1;
+static double g_trace_sample_ratio = 1.0;   /* Head sampling ratio for new traces */
+static legacy_store_t *g_legacy_store = NULL;  /* NULL: simulated DB backend */
 
-        otlp_export_log(g_log_exporter, &record);
-    }
-}
+/* Default SERVICE_F_LEGACY_STORE_RELOAD_SECONDS */
+#define DEFAULT_STORE_RELOAD_SECONDS 5
 
-/* Record request metrics */
-static void record_request_metrics(double duration_ms) {
-    pthread_mutex_lock(&g_metrics_mutex);
-    g_request_count++;
-    g_total_duration_ms += duration_ms;
-    pthread_mutex_unlock(&g_metrics_mutex);
+/* Metrics state; the counters themselves live in request_metrics */
+static pthread_t g_metrics_thread;
+static uint64_t g_metrics_start_nanos = 0;  /* Start of the cumulative series */
+
+/* Series exported per cycle: every table and status, plus the overflow series */
+#define MAX_METRIC_SERIES ((REQUEST_METRICS_MAX_TABLES + 1) * REQUEST_STATUS_COUNT)
+
+/* Attach a collected exemplar, if any, to a histogram point */
+static void set_exemplar(histogram_data_point_t *dp, metric_exemplar_t *exemplar,
+                         const request_metrics_exemplar_t *source) {
+    if (!source->valid) return;
+
+    exemplar->timestamp_nanos = source->time_nanos;
+    exemplar->value = source->value_ms;
+    exemplar->trace_id = source->trace_id;
+    exemplar->span_id = source->span_id;
+    dp->exemplars = exemplar;
+    dp->exemplar_count = 1;
 }
 
 /* Background thread to periodically export metrics */
 static void* metrics_export_thread(void *arg) {
     (void)arg;
 
+    static request_metrics_series_t series[MAX_METRIC_SERIES];
+    static metric_attribute_t attrs[MAX_METRIC_SERIES][2];
+    static metric_data_point_t counter_dps[MAX_METRIC_SERIES];
+    static histogram_data_point_t histogram_dps[MAX_METRIC_SERIES];
+    static metric_exemplar_t exemplars[MAX_METRIC_SERIES];
+    static request_metrics_stage_series_t stages[REQUEST_STAGE_COUNT];
+    static metric_attribute_t stage_attrs[REQUEST_STAGE_COUNT];
+    static histogram_data_point_t stage_dps[REQUEST_STAGE_COUNT];
+    static metric_exemplar_t stage_exemplars[REQUEST_STAGE_COUNT];
+
     while (!g_shutdown) {
         sleep(10); /* Export every 10 seconds */
 
@@ -110,79 +114,213 @@ static void* metrics_export_thread(void *arg) {
         clock_gettime(CLOCK_REALTIME, &ts);
         uint64_t timestamp_nanos = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
 
-        /* Get and reset metrics atomically */
-        pthread_mutex_lock(&g_metrics_mutex);
-        uint64_t request_count = g_request_count;
-        double total_duration = g_total_duration_ms;
-        pthread_mutex_unlock(&g_metrics_mutex);
-
-        if (request_count == 0) continue;
-
-        /* Create counter data point */
-        metric_data_point_t counter_dp = {0};
-        counter_dp.timestamp_nanos = timestamp_nanos;
-        counter_dp.int_value = (int64_t)request_count;
-        counter_dp.is_double = 0;
+        /* Merge the per-thread shards; request threads are never blocked */
+        size_t series_count = request_metrics_collect(series, MAX_METRIC_SERIES, stages);
+        if (series_count == 0) continue;
+
+        for (size_t i = 0; i < series_count; i++) {
+            attrs[i][0].key = "table_name";
+            attrs[i][0].string_value = series[i].table_name;
+            attrs[i][1].key = "status";
+            attrs[i][1].string_value = request_status_name(series[i].status);
+
+            /* Request counter */
+            metric_data_point_t *counter_dp = &counter_dps[i];
+            memset(counter_dp, 0, sizeof(*counter_dp));
+            counter_dp->start_time_nanos = g_metrics_start_nanos;
+            counter_dp->timestamp_nanos = timestamp_nanos;
+            counter_dp->int_value = (int64_t)series[i].count;
+            counter_dp->is_double = 0;
+            counter_dp->attributes = attrs[i];
+            counter_dp->attribute_count = 2;
+
+            /* Latency histogram */
+            histogram_data_point_t *histogram_dp = &histogram_dps[i];
+            memset(histogram_dp, 0, sizeof(*histogram_dp));
+            histogram_dp->start_time_nanos = g_metrics_start_nanos;
+            histogram_dp->timestamp_nanos = timestamp_nanos;
+            histogram_dp->count = series[i].count;
+            histogram_dp->sum = series[i].sum_ms;
+            histogram_dp->bucket_counts = series[i].bucket_counts;
+            histogram_dp->explicit_bounds = request_metrics_bounds;
+            histogram_dp->bucket_count = REQUEST_METRICS_BUCKET_COUNT;
+            histogram_dp->attributes = attrs[i];
+            histogram_dp->attribute_count = 2;
+            set_exemplar(histogram_dp, &exemplars[i], &series[i].exemplar);
+        }
 
-        /* Create gauge data point for average duration */
-        metric_data_point_t gauge_dp = {0};
-        gauge_dp.timestamp_nanos = timestamp_nanos;
-        gauge_dp.double_value = request_count > 0 ? total_duration / request_count : 0;
-        gauge_dp.is_double = 1;
+        /* Stage breakdown across all tables */
+        size_t stage_count = 0;
+        for (int stage = 0; stage < REQUEST_STAGE_COUNT; stage++) {
+            if (stages[stage].count == 0) continue;
+
+            stage_attrs[stage_count].key = "stage";
+            stage_attrs[stage_count].string_value = request_stage_name((request_stage_t)stage);
+
+            histogram_data_point_t *stage_dp = &stage_dps[stage_count];
+            memset(stage_dp, 0, sizeof(*stage_dp));
+            stage_dp->start_time_nanos = g_metrics_start_nanos;
+            stage_dp->timestamp_nanos = timestamp_nanos;
+            stage_dp->count = stages[stage].count;
+            stage_dp->sum = stages[stage].sum_ms;
+            stage_dp->bucket_counts = stages[stage].bucket_counts;
+            stage_dp->explicit_bounds = request_metrics_stage_bounds;
+            stage_dp->bucket_count = REQUEST_METRICS_BUCKET_COUNT;
+            stage_dp->attributes = &stage_attrs[stage_count];
+            stage_dp->attribute_count = 1;
+            set_exemplar(stage_dp, &stage_exemplars[stage_count], &stages[stage].exemplar);
+            stage_count++;
+        }
 
         /* Create metrics */
-        otlp_metric_t metrics[2];
+        otlp_metric_t metrics[3];
 
         metrics[0].name = "grpcarch_service_f_requests_total";
         metrics[0].description = "Total number of requests";
         metrics[0].unit = "1";
         metrics[0].type = METRIC_TYPE_COUNTER;
-        metrics[0].data_points = &counter_dp;
-        metrics[0].data_point_count = 1;
+        metrics[0].data_points = counter_dps;
+        metrics[0].data_point_count = series_count;
         metrics[0].histogram_points = NULL;
         metrics[0].histogram_point_count = 0;
 
         metrics[1].name = "grpcarch_service_f_request_duration_ms";
-        metrics[1].description = "Average request duration in milliseconds";
+        metrics[1].description = "Request duration in milliseconds";
         metrics[1].unit = "ms";
-        metrics[1].type = METRIC_TYPE_GAUGE;
-        metrics[1].data_points = &gauge_dp;
-        metrics[1].data_point_count = 1;
-        metrics[1].histogram_points = NULL;
-        metrics[1].histogram_point_count = 0;
+        metrics[1].type = METRIC_TYPE_HISTOGRAM;
+        metrics[1].data_points = NULL;
+        metrics[1].data_point_count = 0;
+        metrics[1].histogram_points = histogram_dps;
+        metrics[1].histogram_point_count = series_count;
+
+        metrics[2].name = "grpcarch_service_f_stage_duration_ms";
+        metrics[2].description = "Time spent in each stage of a request, in milliseconds";
+        metrics[2].unit = "ms";
+        metrics[2].type = METRIC_TYPE_HISTOGRAM;
+        metrics[2].data_points = NULL;
+        metrics[2].data_point_count = 0;
+        metrics[2].histogram_points = stage_dps;
+        metrics[2].histogram_point_count = stage_count;
 
         /* Export metrics */
-        otlp_export_metrics(g_metrics_exporter, metrics, 2);
+        otlp_export_metrics(g_metrics_exporter, metrics, stage_count > 0 ? 3 : 2);
     }
 
     return NULL;
 }
 
-/* Request context for async handling */
+/* Worker pool defaults */
+#define DEFAULT_PENDING_CALLS_PER_WORKER 8
+#define MAX_WORKER_THREADS 64
+
+/* First arena block per call; holds the unpacked request of a typical RPC */
+#define CALL_ARENA_SIZE 1024
+
+/* Bulk RPC defaults */
+#define DEFAULT_MAX_BATCH_RECORDS 1000
+#define DEFAULT_STREAM_CHUNK_BYTES 65536
+
+/* RPCs served; indexes g_methods */
+typedef enum {
+    METHOD_FETCH,           /* FetchLegacyData */
+    METHOD_FETCH_BATCH,     /* FetchLegacyDataBatch */
+    METHOD_STREAM,          /* StreamLegacyData */
+    METHOD_COUNT
+} call_method_t;
+
+static const struct {
+    const char *path;
+    const char *name;
+} g_methods[METHOD_COUNT] = {
+    { "/grpcarch.ServiceF/FetchLegacyData", "FetchLegacyData" },
+    { "/grpcarch.ServiceF/FetchLegacyDataBatch", "FetchLegacyDataBatch" },
+    { "/grpcarch.ServiceF/StreamLegacyData", "StreamLegacyData" },
+};
+
+/* Lifecycle of a call; the call_context_t pointer itself is the CQ tag */
+typedef enum {
+    CALL_STATE_REQUESTED,   /* grpc_server_request_call posted, waiting for a client */
+    CALL_STATE_RECEIVING,   /* RECV_MESSAGE batch in flight */
+    CALL_STATE_DB_WAIT,     /* parked on the worker's timer heap (simulated DB lookup) */
+    CALL_STATE_STREAMING,   /* StreamLegacyData message in flight */
+    CALL_STATE_SENDING,     /* response + status batch in flight */
+} call_state_t;
+
+typedef struct call_context call_context_t;
+
+/* Server worker: one thread driving one completion queue */
 typedef struct {
+    int index;
+    grpc_completion_queue *cq;
+    pthread_t thread;
+
+    /* Min-heap of calls waiting on a timer, ordered by timer_due */
+    call_context_t **timers;
+    size_t timer_count;
+    size_t timer_capacity;
+} server_worker_t;
+
+/* Request context for async handling */
+struct call_context {
+    call_state_t state;
+    server_worker_t *worker;
     grpc_call *call;
     grpc_metadata_array request_metadata;
     grpc_byte_buffer *request_payload;
     grpc_call_details call_details;
-    int request_id;
-} call_context_t;
-
-/* Generate a random trace ID (16 bytes as hex string) */
-static void generate_trace_id(char *out, size_t len) {
-    static const char hex[] = "0123456789abcdef";
-    for (size_t i = 0; i < len - 1 && i < 32; i++) {
-        out[i] = hex[rand() % 16];
-    }
-    out[len - 1] = '\0';
+    call_method_t method;
+
+    /* Request state carried from RECEIVING to SENDING */
+    arena_t arena;                          /* Backs the unpacked request */
+    Grpcarch__LegacyDataRequest *request;               /* METHOD_FETCH */
+    Grpcarch__LegacyDataBatchRequest *batch_request;    /* METHOD_FETCH_BATCH */
+    Grpcarch__LegacyDataRangeRequest *range_request;    /* METHOD_STREAM */
+    const char *table_name;                 /* From the request; "unknown" if it has none */
+    uint8_t *record_trailer;                /* Encoded fields map shared by the call's records */
+    size_t record_trailer_len;
+    size_t record_count;                    /* Records returned */
+    grpc_byte_buffer *response_payload;
+    int sent_initial_metadata;
+    grpc_slice status_details;
+    grpc_status_code status_code;
+    uint64_t start_time;    /* CLOCK_REALTIME, for the span */
+    uint64_t mono_start;    /* CLOCK_MONOTONIC, for durations */
+    uint64_t stage_mark;    /* CLOCK_MONOTONIC end of the previous stage */
+    uint64_t stage_nanos[REQUEST_STAGE_COUNT];
+    uint64_t timer_due;     /* CLOCK_MONOTONIC nanos, valid in CALL_STATE_DB_WAIT */
+    uint8_t trace_id[OTLP_TRACE_ID_SIZE];
+    uint8_t parent_span_id[OTLP_SPAN_ID_SIZE];
+    uint8_t span_id[OTLP_SPAN_ID_SIZE];
+    int has_parent;
+    int sampled;            /* Export this call's span */
+
+    /* StreamLegacyData cursor; the snapshot is held until the call is cleaned up */
+    legacy_snapshot_t *snapshot;
+    size_t stream_pos;                      /* Next position in ID order */
+    size_t stream_remaining;                /* Records left under the request's limit */
+    grpc_byte_buffer *next_payload;         /* Encoded while the previous message is sent */
+    int stream_failed;
+};
+
+static server_worker_t g_workers[MAX_WORKER_THREADS];
+static int g_worker_count = 0;
+static int g_pending_calls_per_worker = DEFAULT_PENDING_CALLS_PER_WORKER;
+static size_t g_response_compression_bytes = 0;  /* Compress responses this large; 0 disables */
+static size_t g_max_batch_records = DEFAULT_MAX_BATCH_RECORDS;
+static size_t g_stream_chunk_bytes = DEFAULT_STREAM_CHUNK_BYTES;
+
+/* Generate a random trace ID (OTLP_TRACE_ID_SIZE bytes, never all zero) */
+static void generate_trace_id(uint8_t *out) {
+    do {
+        rng_fill(out, OTLP_TRACE_ID_SIZE);
+    } while (!trace_id_is_valid(out, OTLP_TRACE_ID_SIZE));
 }
 
-/* Generate a random span ID (8 bytes as hex string) */
-static void generate_span_id(char *out, size_t len) {
-    static const char hex[] = "0123456789abcdef";
-    for (size_t i = 0; i < len - 1 && i < 16; i++) {
-        out[i] = hex[rand() % 16];
-    }
-    out[len - 1] = '\0';
+/* Generate a random span ID (OTLP_SPAN_ID_SIZE bytes, never all zero) */
+static void generate_span_id(uint8_t *out) {
+    do {
+        rng_fill(out, OTLP_SPAN_ID_SIZE);
+    } while (!trace_id_is_valid(out, OTLP_SPAN_ID_SIZE));
 }
 
 /* Get current time in nanoseconds */
@@ -192,227 +330,656 @@ static uint64_t get_time_nanos(void) {
     return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
 }
 
-/* Extract trace context from metadata */
+/*
+ * Extract trace context from metadata; starts a new trace if none is present
+ *
+ * Sampling is parent-based: a caller's sampled flag is honoured, and new
+ * traces are sampled at SERVICE_F_TRACE_SAMPLE_RATIO.
+ */
 static void extract_trace_context(grpc_metadata_array *metadata,
-                                   char *trace_id, size_t trace_id_len,
-                                   char *parent_span_id, size_t parent_span_len) {
-    trace_id[0] = '\0';
-    parent_span_id[0] = '\0';
+                                   uint8_t *trace_id, uint8_t *parent_span_id,
+                                   int *has_parent, int *sampled) {
+    uint8_t trace_flags = 0;
+    *has_parent = 0;
 
     for (size_t i = 0; i < metadata->count; i++) {
         grpc_metadata *md = &metadata->metadata[i];
-        const char *key = grpc_slice_to_c_string(md->key);
-
-        if (strcmp(key, "traceparent") == 0) {
-            /* W3C trace context format: 00-traceid-spanid-flags */
-            char *value = grpc_slice_to_c_string(md->value);
-            if (strlen(value) >= 55) {
-                /* Extract trace_id (32 chars starting at position 3) */
-                strncpy(trace_id, value + 3, 32);
-                trace_id[32] = '\0';
-                /* Extract parent span_id (16 chars starting at position 36) */
-                strncpy(parent_span_id, value + 36, 16);
-                parent_span_id[16] = '\0';
-            }
-            gpr_free(value);
+
+        /* Compare and parse in place; nothing is copied out of the slices */
+        if (grpc_slice_str_cmp(md->key, "traceparent") == 0) {
+            *has_parent = trace_context_parse_traceparent(
+                (const char*)GRPC_SLICE_START_PTR(md->value), GRPC_SLICE_LENGTH(md->value),
+                trace_id, parent_span_id, &trace_flags) == 0;
+            break;
         }
-        gpr_free((void*)key);
     }
 
     /* Generate new trace ID if not provided */
-    if (trace_id[0] == '\0') {
-        generate_trace_id(trace_id, trace_id_len);
+    if (!*has_parent) {
+        generate_trace_id(trace_id);
+        *sampled = trace_id_ratio_sampled(trace_id, g_trace_sample_ratio);
+    } else {
+        *sampled = (trace_flags & TRACE_FLAG_SAMPLED) != 0;
     }
 }
 
-/* Simulate random delay (3-8ms) */
-static void simulate_db_delay(void) {
-    int delay_ms = 3 + (rand() % 6);
-    usleep(delay_ms * 1000);
+/* Simulated DB lookup latency (3-8ms) */
+static uint64_t simulate_db_delay_nanos(void) {
+    uint32_t delay_ms = 3 + rng_uniform(6);
+    return (uint64_t)delay_ms * 1000000ULL;
+}
+
+/* Monotonic clock for timers */
+static uint64_t get_monotonic_nanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* Close the call's current stage; returns the monotonic time it ended */
+static uint64_t end_stage(call_context_t *ctx, request_stage_t stage) {
+    uint64_t now = get_monotonic_nanos();
+    ctx->stage_nanos[stage] += now - ctx->stage_mark;
+    ctx->stage_mark = now;
+    return now;
 }
 
-/* Handle FetchLegacyData RPC */
-static void handle_fetch_legacy_data(call_context_t *ctx) {
-    uint64_t start_time = get_time_nanos();
-    char trace_id[64] = {0};
-    char parent_span_id[32] = {0};
-    char span_id[32] = {0};
+/* Park a call on the worker's timer heap until due (monotonic nanos) */
+static int timer_heap_push(server_worker_t *worker, call_context_t *ctx, uint64_t due) {
+    if (worker->timer_count == worker->timer_capacity) {
+        size_t new_capacity = worker->timer_capacity ? worker->timer_capacity * 2 : 64;
+        call_context_t **timers = realloc(worker->timers, new_capacity * sizeof(call_context_t*));
+        if (!timers) return -1;
+        worker->timers = timers;
+        worker->timer_capacity = new_capacity;
+    }
 
-    /* Extract trace context from incoming metadata */
-    extract_trace_context(&ctx->request_metadata, trace_id, sizeof(trace_id),
-                          parent_span_id, sizeof(parent_span_id));
+    ctx->timer_due = due;
+    size_t i = worker->timer_count++;
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (worker->timers[parent]->timer_due <= due) break;
+        worker->timers[i] = worker->timers[parent];
+        i = parent;
+    }
+    worker->timers[i] = ctx;
+    return 0;
+}
 
-    /* Generate span ID for this operation */
-    generate_span_id(span_id, sizeof(span_id));
+/* Remove and return the earliest timer */
+static call_context_t* timer_heap_pop(server_worker_t *worker) {
+    if (worker->timer_count == 0) return NULL;
 
-    /* Deserialize request */
-    Grpcarch__LegacyDataRequest *request = NULL;
-    if (ctx->request_payload != NULL) {
-        grpc_byte_buffer_reader reader;
-        grpc_byte_buffer_reader_init(&reader, ctx->request_payload);
-        grpc_slice slice = grpc_byte_buffer_reader_readall(&reader);
-
-        request = grpcarch__legacy_data_request__unpack(
-            NULL,
-            GRPC_SLICE_LENGTH(slice),
-            GRPC_SLICE_START_PTR(slice)
-        );
+    call_context_t *top = worker->timers[0];
+    call_context_t *last = worker->timers[--worker->timer_count];
+    size_t n = worker->timer_count;
+    size_t i = 0;
 
-        grpc_slice_unref(slice);
-        grpc_byte_buffer_reader_destroy(&reader);
+    while (2 * i + 1 < n) {
+        size_t child = 2 * i + 1;
+        if (child + 1 < n && worker->timers[child + 1]->timer_due < worker->timers[child]->timer_due) {
+            child++;
+        }
+        if (last->timer_due <= worker->timers[child]->timer_due) break;
+        worker->timers[i] = worker->timers[child];
+        i = child;
     }
+    if (n > 0) worker->timers[i] = last;
+    return top;
+}
 
-    const char *record_id = request && request->record_id ? request->record_id : "unknown";
-    const char *table_name = request && request->table_name ? request->table_name : "unknown";
+static void cleanup_call_context(call_context_t *ctx);
 
-    char log_msg[256];
-    snprintf(log_msg, sizeof(log_msg), "FetchLegacyData called - record_id: %s, table: %s",
-             record_id, table_name);
-    log_otlp(LOG_SEVERITY_INFO, trace_id, span_id, log_msg);
+/* Fill in a SEND_INITIAL_METADATA op; the call is compressed if its first message is large */
+static void initial_metadata_op(call_context_t *ctx, grpc_op *op, grpc_byte_buffer *first_message) {
+    op->op = GRPC_OP_SEND_INITIAL_METADATA;
+    op->data.send_initial_metadata.count = 0;
+    if (g_response_compression_bytes > 0 && first_message &&
+        grpc_byte_buffer_length(first_message) >= g_response_compression_bytes) {
+        op->data.send_initial_metadata.maybe_compression_level.is_set = 1;
+        op->data.send_initial_metadata.maybe_compression_level.level = GRPC_COMPRESS_LEVEL_LOW;
+    }
+    op->flags = 0;
+    ctx->sent_initial_metadata = 1;
+}
 
-    /* Simulate DB lookup delay */
-    simulate_db_delay();
+/* Start the final SEND_INITIAL_METADATA/SEND_MESSAGE/SEND_STATUS batch for a call */
+static void start_send(call_context_t *ctx, grpc_status_code code, const char *details) {
+    ctx->status_details = grpc_slice_from_static_string(details);
+    ctx->status_code = code;
 
-    /* Build response */
-    Grpcarch__LegacyDataResponse response = GRPCARCH__LEGACY_DATA_RESPONSE__INIT;
-    Grpcarch__ResponseStatus status = GRPCARCH__RESPONSE_STATUS__INIT;
-    Grpcarch__LegacyRecord record = GRPCARCH__LEGACY_RECORD__INIT;
+    grpc_op ops[3];
+    memset(ops, 0, sizeof(ops));
+    size_t nops = 0;
 
-    status.success = 1;
-    char status_msg[256];
-    snprintf(status_msg, sizeof(status_msg), "Record fetched successfully from %s", table_name);
-    status.message = status_msg;
+    /* A stream has sent its initial metadata with the first message */
+    if (!ctx->sent_initial_metadata) {
+        initial_metadata_op(ctx, &ops[nops], ctx->response_payload);
+        nops++;
+    }
 
-    record.id = (char*)record_id;
+    if (ctx->response_payload) {
+        ops[nops].op = GRPC_OP_SEND_MESSAGE;
+        ops[nops].data.send_message.send_message = ctx->response_payload;
+        ops[nops].flags = 0;
+        nops++;
+    }
 
-    /* Build raw_data JSON */
-    char raw_data[512];
-    snprintf(raw_data, sizeof(raw_data),
-             "{\"source\": \"%s\", \"data\": \"legacy_value_%s\"}",
-             table_name, record_id);
-    record.raw_data.data = (uint8_t*)raw_data;
-    record.raw_data.len = strlen(raw_data);
+    ops[nops].op = GRPC_OP_SEND_STATUS_FROM_SERVER;
+    ops[nops].data.send_status_from_server.trailing_metadata_count = 0;
+    ops[nops].data.send_status_from_server.status = code;
+    ops[nops].data.send_status_from_server.status_details = &ctx->status_details;
+    ops[nops].flags = 0;
+    nops++;
 
-    time_t now = time(NULL);
-    record.created_at = now - 86400;
-    record.updated_at = now;
+    ctx->state = CALL_STATE_SENDING;
+    grpc_call_error err = grpc_call_start_batch(ctx->call, ops, nops, ctx, NULL);
+    if (err != GRPC_CALL_OK) {
+        LOG_RATE_LIMITED(10, LOG_SEVERITY_ERROR, ctx->trace_id, ctx->span_id,
+                         "Error sending response: %d", err);
+        /* No completion will arrive for this call; ctx must not be used after this */
+        cleanup_call_context(ctx);
+    }
+}
+
+/* Send one StreamLegacyData message, with the initial metadata ahead of the first;
+ * on failure the call is cleaned up and -1 returned */
+static int start_stream_message(call_context_t *ctx) {
+    grpc_op ops[2];
+    memset(ops, 0, sizeof(ops));
+    size_t nops = 0;
+
+    if (!ctx->sent_initial_metadata) {
+        initial_metadata_op(ctx, &ops[nops], ctx->response_payload);
+        nops++;
+    }
+
+    ops[nops].op = GRPC_OP_SEND_MESSAGE;
+    ops[nops].data.send_message.send_message = ctx->response_payload;
+    ops[nops].flags = 0;
+    nops++;
 
-    /* Add fields map */
-    record.n_fields = 2;
+    ctx->state = CALL_STATE_STREAMING;
+    grpc_call_error err = grpc_call_start_batch(ctx->call, ops, nops, ctx, NULL);
+    if (err != GRPC_CALL_OK) {
+        LOG_RATE_LIMITED(10, LOG_SEVERITY_ERROR, ctx->trace_id, ctx->span_id,
+                         "Error sending stream message: %d", err);
+        cleanup_call_context(ctx);
+        return -1;
+    }
+    return 0;
+}
+
+/* The request message as one contiguous slice; the caller unrefs it */
+static grpc_slice request_bytes(grpc_byte_buffer *payload) {
+    if (payload->type == GRPC_BB_RAW &&
+        payload->data.raw.compression == GRPC_COMPRESS_NONE &&
+        payload->data.raw.slice_buffer.count == 1) {
+        /* Common case: the whole message arrived in one slice, parse it in place */
+        return grpc_slice_ref(payload->data.raw.slice_buffer.slices[0]);
+    }
+
+    grpc_slice slice = grpc_empty_slice();
+    grpc_byte_buffer_reader reader;
+    if (grpc_byte_buffer_reader_init(&reader, payload)) {
+        slice = grpc_byte_buffer_reader_readall(&reader);
+        grpc_byte_buffer_reader_destroy(&reader);
+    }
+    return slice;
+}
+
+/* Deserialize the request into the call's arena; sets ctx->table_name */
+static void parse_request(call_context_t *ctx) {
+    const char *table_name = NULL;
+
+    if (ctx->request_payload != NULL) {
+        ProtobufCAllocator allocator = arena_protobuf_allocator(&ctx->arena);
+        grpc_slice slice = request_bytes(ctx->request_payload);
+        size_t len = GRPC_SLICE_LENGTH(slice);
+        const uint8_t *data = GRPC_SLICE_START_PTR(slice);
+
+        switch (ctx->method) {
+            case METHOD_FETCH:
+                ctx->request = grpcarch__legacy_data_request__unpack(&allocator, len, data);
+                if (ctx->request) table_name = ctx->request->table_name;
+                break;
+            case METHOD_FETCH_BATCH:
+                ctx->batch_request = grpcarch__legacy_data_batch_request__unpack(&allocator, len, data);
+                if (ctx->batch_request) table_name = ctx->batch_request->table_name;
+                break;
+            case METHOD_STREAM:
+                ctx->range_request = grpcarch__legacy_data_range_request__unpack(&allocator, len, data);
+                if (ctx->range_request) table_name = ctx->range_request->table_name;
+                break;
+            default:
+                break;
+        }
+        grpc_slice_unref(slice);
+    }
+
+    ctx->table_name = table_name ? table_name : "unknown";
+}
+
+/* Encode the fields map every record of the call carries, once per call */
+static void prepare_record_trailer(call_context_t *ctx) {
+    Grpcarch__LegacyRecord fields_only = GRPCARCH__LEGACY_RECORD__INIT;
     Grpcarch__LegacyRecord__FieldsEntry *entries[2];
     Grpcarch__LegacyRecord__FieldsEntry entry1 = GRPCARCH__LEGACY_RECORD__FIELDS_ENTRY__INIT;
     Grpcarch__LegacyRecord__FieldsEntry entry2 = GRPCARCH__LEGACY_RECORD__FIELDS_ENTRY__INIT;
 
     entry1.key = "source";
-    entry1.value = (char*)table_name;
+    entry1.value = (char*)ctx->table_name;
     entry2.key = "fetched_by";
     entry2.value = "service-f";
 
     entries[0] = &entry1;
     entries[1] = &entry2;
-    record.fields = entries;
+    fields_only.fields = entries;
+    fields_only.n_fields = 2;
 
-    response.status = &status;
-    response.record = &record;
+    size_t len = grpcarch__legacy_record__get_packed_size(&fields_only);
+    ctx->record_trailer = arena_alloc(&ctx->arena, len);
+    if (ctx->record_trailer) {
+        ctx->record_trailer_len = grpcarch__legacy_record__pack(&fields_only, ctx->record_trailer);
+    }
+}
 
-    /* Serialize response */
-    size_t response_len = grpcarch__legacy_data_response__get_packed_size(&response);
-    uint8_t *response_buf = malloc(response_len);
-    grpcarch__legacy_data_response__pack(&response, response_buf);
+/* Append a ResponseStatus as field 1, which it is in every unary response */
+static void encode_status(record_encoder_t *enc, const char *message) {
+    Grpcarch__ResponseStatus status = GRPCARCH__RESPONSE_STATUS__INIT;
+    status.success = 1;
+    status.message = (char*)message;
 
-    /* Create byte buffer for response */
-    grpc_slice response_slice = grpc_slice_from_copied_buffer((char*)response_buf, response_len);
-    grpc_byte_buffer *response_bb = grpc_raw_byte_buffer_create(&response_slice, 1);
+    size_t len = grpcarch__response_status__get_packed_size(&status);
+    uint8_t *out = record_encoder_field(enc, 1, len);
+    if (out) grpcarch__response_status__pack(&status, out);
+}
 
-    /* Send response */
-    grpc_metadata_array trailing_metadata;
-    grpc_metadata_array_init(&trailing_metadata);
+/* Send an encoded unary response; the encoder is destroyed */
+static void send_encoded_response(call_context_t *ctx, record_encoder_t *enc) {
+    /* The byte buffer stays alive until the send completes */
+    ctx->response_payload = record_encoder_finish(enc);
+    record_encoder_destroy(enc);
+    end_stage(ctx, REQUEST_STAGE_RESPOND);
 
-    grpc_op ops[3];
-    memset(ops, 0, sizeof(ops));
+    if (!ctx->response_payload) {
+        start_send(ctx, GRPC_STATUS_RESOURCE_EXHAUSTED, "Out of memory");
+        return;
+    }
+    start_send(ctx, GRPC_STATUS_OK, "OK");
+}
 
-    ops[0].op = GRPC_OP_SEND_INITIAL_METADATA;
-    ops[0].data.send_initial_metadata.count = 0;
-    ops[0].flags = 0;
+/* Answer FetchLegacyData from the legacy store */
+static void fetch_stored_record(call_context_t *ctx) {
+    const char *record_id = ctx->request && ctx->request->record_id ? ctx->request->record_id : "";
+
+    legacy_record_t stored;
+    legacy_snapshot_t *snapshot = legacy_store_lookup(g_legacy_store, ctx->table_name,
+                                                      record_id, strlen(record_id), &stored);
+    end_stage(ctx, REQUEST_STAGE_DB);
+    if (!snapshot) {
+        start_send(ctx, GRPC_STATUS_NOT_FOUND, "Record not found");
+        return;
+    }
 
-    ops[1].op = GRPC_OP_SEND_MESSAGE;
-    ops[1].data.send_message.send_message = response_bb;
-    ops[1].flags = 0;
+    char status_msg[256];
+    snprintf(status_msg, sizeof(status_msg), "Record fetched successfully from %s", ctx->table_name);
+
+    /* Large raw_data is sent straight from the mapping; the buffer holds its own reference */
+    record_encoder_t enc;
+    record_encoder_init(&enc, snapshot);
+    prepare_record_trailer(ctx);
+    encode_status(&enc, status_msg);
+    record_encoder_record(&enc, 2, &stored, ctx->record_trailer, ctx->record_trailer_len);  /* .record */
+    ctx->record_count = 1;
+
+    send_encoded_response(ctx, &enc);
+    legacy_snapshot_release(snapshot);
+}
 
-    ops[2].op = GRPC_OP_SEND_STATUS_FROM_SERVER;
-    ops[2].data.send_status_from_server.trailing_metadata_count = 0;
-    ops[2].data.send_status_from_server.status = GRPC_STATUS_OK;
-    grpc_slice status_details = grpc_slice_from_static_string("OK");
-    ops[2].data.send_status_from_server.status_details = &status_details;
-    ops[2].flags = 0;
+/* Answer FetchLegacyDataBatch from the legacy store, against one snapshot */
+static void fetch_stored_batch(call_context_t *ctx) {
+    Grpcarch__LegacyDataBatchRequest *request = ctx->batch_request;
 
-    grpc_call_error err = grpc_call_start_batch(ctx->call, ops, 3, (void*)(intptr_t)2, NULL);
-    if (err != GRPC_CALL_OK) {
-        fprintf(stderr, "[Service F] Error sending response: %d\n", err);
+    legacy_snapshot_t *snapshot = legacy_store_acquire(g_legacy_store, ctx->table_name);
+    if (!snapshot) {
+        end_stage(ctx, REQUEST_STAGE_DB);
+        start_send(ctx, GRPC_STATUS_NOT_FOUND, "Table not found");
+        return;
     }
 
-    /* Wait for send to complete */
-    grpc_event ev;
-    do {
-        ev = grpc_completion_queue_next(g_cq, gpr_inf_future(GPR_CLOCK_REALTIME), NULL);
-    } while (ev.type != GRPC_OP_COMPLETE || ev.tag != (void*)(intptr_t)2);
+    record_encoder_t enc;
+    record_encoder_init(&enc, snapshot);
+    prepare_record_trailer(ctx);
+
+    for (size_t i = 0; i < request->n_record_ids; i++) {
+        const char *record_id = request->record_ids[i];
+        legacy_record_t stored;
+        if (legacy_snapshot_find(snapshot, record_id, strlen(record_id), &stored) == 0) {
+            record_encoder_record(&enc, 2, &stored, ctx->record_trailer, ctx->record_trailer_len);  /* .records */
+            ctx->record_count++;
+        } else {
+            record_encoder_bytes(&enc, 3, record_id, strlen(record_id));  /* .missing_record_ids */
+        }
+    }
+    end_stage(ctx, REQUEST_STAGE_DB);
+
+    /* The status goes last, once the counts are known */
+    char status_msg[256];
+    snprintf(status_msg, sizeof(status_msg), "Fetched %zu of %zu records from %s",
+             ctx->record_count, request->n_record_ids, ctx->table_name);
+    encode_status(&enc, status_msg);
+
+    send_encoded_response(ctx, &enc);
+    legacy_snapshot_release(snapshot);
+}
+
+/* Encode the next StreamLegacyData message; NULL once the range is exhausted */
+static grpc_byte_buffer* encode_stream_chunk(call_context_t *ctx) {
+    const char *end_id = ctx->range_request->end_record_id ? ctx->range_request->end_record_id : "";
+    size_t end_len = strlen(end_id);
+
+    record_encoder_t enc;
+    record_encoder_init(&enc, ctx->snapshot);
+
+    while (ctx->stream_remaining > 0 && record_encoder_size(&enc) < g_stream_chunk_bytes) {
+        legacy_record_t record;
+        if (legacy_snapshot_record_at(ctx->snapshot, ctx->stream_pos, &record) != 0 ||
+            (end_len > 0 && legacy_record_compare_id(&record, end_id, end_len) >= 0)) {
+            ctx->stream_remaining = 0;
+            break;
+        }
+        record_encoder_record(&enc, 1, &record, ctx->record_trailer, ctx->record_trailer_len);  /* .records */
+        ctx->stream_pos++;
+        ctx->stream_remaining--;
+        ctx->record_count++;
+    }
 
-    uint64_t end_time = get_time_nanos();
-    double duration_ms = (end_time - start_time) / 1000000.0;
+    grpc_byte_buffer *chunk = NULL;
+    if (record_encoder_size(&enc) > 0) {
+        chunk = record_encoder_finish(&enc);
+        if (!chunk) {
+            ctx->stream_failed = 1;
+            ctx->stream_remaining = 0;
+        }
+    }
+    record_encoder_destroy(&enc);
+    return chunk;
+}
 
-    snprintf(log_msg, sizeof(log_msg), "Record fetched successfully (duration: %.2fms)", duration_ms);
-    log_otlp(LOG_SEVERITY_INFO, trace_id, span_id, log_msg);
+/* Send the next StreamLegacyData message, or the status once the range is done */
+static void stream_next(call_context_t *ctx) {
+    end_stage(ctx, REQUEST_STAGE_SEND);
+    if (ctx->response_payload) {
+        grpc_byte_buffer_destroy(ctx->response_payload);
+        ctx->response_payload = NULL;
+    }
+
+    grpc_byte_buffer *chunk = ctx->next_payload ? ctx->next_payload : encode_stream_chunk(ctx);
+    ctx->next_payload = NULL;
+    if (!chunk) {
+        end_stage(ctx, REQUEST_STAGE_DB);
+        if (ctx->stream_failed) {
+            start_send(ctx, GRPC_STATUS_RESOURCE_EXHAUSTED, "Out of memory");
+        } else {
+            start_send(ctx, GRPC_STATUS_OK, "OK");
+        }
+        return;
+    }
+
+    ctx->response_payload = chunk;
+    if (start_stream_message(ctx) != 0) return;
+
+    /* Read the following chunk out of the mapping while this one is on the wire */
+    ctx->next_payload = encode_stream_chunk(ctx);
+    end_stage(ctx, REQUEST_STAGE_DB);
+}
+
+/* Start StreamLegacyData: walk the table's ID order from start_record_id */
+static void start_stream(call_context_t *ctx) {
+    Grpcarch__LegacyDataRangeRequest *request = ctx->range_request;
+
+    if (!g_legacy_store) {
+        start_send(ctx, GRPC_STATUS_FAILED_PRECONDITION, "StreamLegacyData requires the legacy store");
+        return;
+    }
+    if (!request) {
+        start_send(ctx, GRPC_STATUS_INVALID_ARGUMENT, "Malformed request");
+        return;
+    }
+
+    /* The call keeps this snapshot to the end, so a reload never splits the range */
+    ctx->snapshot = legacy_store_acquire(g_legacy_store, ctx->table_name);
+    if (!ctx->snapshot) {
+        start_send(ctx, GRPC_STATUS_NOT_FOUND, "Table not found");
+        return;
+    }
+
+    const char *start_id = request->start_record_id ? request->start_record_id : "";
+    if (legacy_snapshot_seek(ctx->snapshot, start_id, strlen(start_id), &ctx->stream_pos) != 0) {
+        start_send(ctx, GRPC_STATUS_FAILED_PRECONDITION, "Table snapshot has no ID order index");
+        return;
+    }
+    ctx->stream_remaining = request->limit > 0 ? (size_t)request->limit : SIZE_MAX;
+    prepare_record_trailer(ctx);
+    end_stage(ctx, REQUEST_STAGE_DB);
+
+    stream_next(ctx);
+}
+
+/* Handle a call once its request message has arrived */
+static void handle_request(call_context_t *ctx) {
+    ctx->start_time = get_time_nanos();
+    ctx->mono_start = ctx->stage_mark = get_monotonic_nanos();
+
+    /* Extract trace context from incoming metadata */
+    extract_trace_context(&ctx->request_metadata, ctx->trace_id, ctx->parent_span_id,
+                          &ctx->has_parent, &ctx->sampled);
+
+    /* Generate span ID for this operation */
+    generate_span_id(ctx->span_id);
+
+    parse_request(ctx);
+    end_stage(ctx, REQUEST_STAGE_PARSE);
+
+    switch (ctx->method) {
+        case METHOD_FETCH: {
+            const char *record_id = ctx->request && ctx->request->record_id ?
+                                    ctx->request->record_id : "unknown";
+            LOG_AT(LOG_SEVERITY_INFO, ctx->trace_id, ctx->span_id,
+                   "FetchLegacyData called - record_id: %s, table: %s", record_id, ctx->table_name);
+            break;
+        }
+        case METHOD_FETCH_BATCH:
+            LOG_AT(LOG_SEVERITY_INFO, ctx->trace_id, ctx->span_id,
+                   "FetchLegacyDataBatch called - records: %zu, table: %s",
+                   ctx->batch_request ? ctx->batch_request->n_record_ids : 0, ctx->table_name);
+            break;
+        case METHOD_STREAM:
+            LOG_AT(LOG_SEVERITY_INFO, ctx->trace_id, ctx->span_id,
+                   "StreamLegacyData called - range: [%s, %s), table: %s",
+                   ctx->range_request && ctx->range_request->start_record_id ?
+                       ctx->range_request->start_record_id : "",
+                   ctx->range_request && ctx->range_request->end_record_id ?
+                       ctx->range_request->end_record_id : "",
+                   ctx->table_name);
+            break;
+        default:
+            break;
+    }
+    end_stage(ctx, REQUEST_STAGE_TELEMETRY);
+
+    switch (ctx->method) {
+        case METHOD_FETCH_BATCH:
+            if (!ctx->batch_request) {
+                start_send(ctx, GRPC_STATUS_INVALID_ARGUMENT, "Malformed request");
+                return;
+            }
+            if (ctx->batch_request->n_record_ids > g_max_batch_records) {
+                start_send(ctx, GRPC_STATUS_INVALID_ARGUMENT, "Too many record IDs in batch");
+                return;
+            }
+            break;
+        case METHOD_STREAM:
+            start_stream(ctx);
+            return;
+        default:
+            break;
+    }
+
+    /* Snapshot lookups only touch the page cache, so they complete inline */
+    if (g_legacy_store) {
+        if (ctx->method == METHOD_FETCH_BATCH) {
+            fetch_stored_batch(ctx);
+        } else {
+            fetch_stored_record(ctx);
+        }
+        return;
+    }
+
+    /* Simulate DB lookup delay without blocking the worker; a batch costs one lookup */
+    ctx->state = CALL_STATE_DB_WAIT;
+    if (timer_heap_push(ctx->worker, ctx, get_monotonic_nanos() + simulate_db_delay_nanos()) != 0) {
+        LOG_RATE_LIMITED(10, LOG_SEVERITY_WARN, ctx->trace_id, ctx->span_id,
+                         "Failed to schedule DB lookup, rejecting call");
+        start_send(ctx, GRPC_STATUS_RESOURCE_EXHAUSTED, "Server overloaded");
+    }
+}
+
+/* The simulated backend's record for an ID; raw receives its raw_data */
+static void simulated_record(const char *table_name, const char *record_id,
+                             char *raw, size_t raw_size, legacy_record_t *out) {
+    snprintf(raw, raw_size, "{\"source\": \"%s\", \"data\": \"legacy_value_%s\"}",
+             table_name, record_id);
+
+    time_t now = time(NULL);
+    out->id = record_id;
+    out->id_len = strlen(record_id);
+    out->raw_data = (const uint8_t*)raw;
+    out->raw_len = strlen(raw);
+    out->created_at = now - 86400;
+    out->updated_at = now;
+}
+
+/* Continuation once the simulated DB lookup has completed */
+static void finish_db_lookup(call_context_t *ctx) {
+    end_stage(ctx, REQUEST_STAGE_DB);
+
+    record_encoder_t enc;
+    record_encoder_init(&enc, NULL);
+    prepare_record_trailer(ctx);
+
+    char raw_data[512];
+    char status_msg[256];
+    legacy_record_t record;
+
+    if (ctx->method == METHOD_FETCH_BATCH) {
+        Grpcarch__LegacyDataBatchRequest *request = ctx->batch_request;
+        for (size_t i = 0; i < request->n_record_ids; i++) {
+            simulated_record(ctx->table_name, request->record_ids[i], raw_data, sizeof(raw_data), &record);
+            record_encoder_record(&enc, 2, &record, ctx->record_trailer, ctx->record_trailer_len);
+        }
+        ctx->record_count = request->n_record_ids;
+        snprintf(status_msg, sizeof(status_msg), "Fetched %zu of %zu records from %s",
+                 ctx->record_count, request->n_record_ids, ctx->table_name);
+    } else {
+        const char *record_id = ctx->request && ctx->request->record_id ?
+                                ctx->request->record_id : "unknown";
+        simulated_record(ctx->table_name, record_id, raw_data, sizeof(raw_data), &record);
+        record_encoder_record(&enc, 2, &record, ctx->record_trailer, ctx->record_trailer_len);
+        ctx->record_count = 1;
+        snprintf(status_msg, sizeof(status_msg), "Record fetched successfully from %s", ctx->table_name);
+    }
+    encode_status(&enc, status_msg);
+
+    /* Send response; completion is picked up by the worker loop */
+    send_encoded_response(ctx, &enc);
+}
+
+/* Finish a call after its status has been sent */
+static void complete_call(call_context_t *ctx) {
+    /* Durations come from the monotonic clock; wall time only anchors the span */
+    uint64_t elapsed_nanos = end_stage(ctx, REQUEST_STAGE_SEND) - ctx->mono_start;
+    uint64_t end_time = ctx->start_time + elapsed_nanos;
+    double duration_ms = elapsed_nanos / 1000000.0;
+
+    /* Only sampled calls can serve as exemplars; others have no trace to link to */
+    const uint8_t *exemplar_trace = ctx->sampled ? ctx->trace_id : NULL;
+    const uint8_t *exemplar_span = ctx->sampled ? ctx->span_id : NULL;
+
+    const char *method = g_methods[ctx->method].name;
+    int ok = ctx->status_code == GRPC_STATUS_OK;
+
+    if (!ok) {
+        /* Failures come in bursts when the server sheds load */
+        LOG_RATE_LIMITED(100, LOG_SEVERITY_ERROR, ctx->trace_id, ctx->span_id,
+                         "%s failed with status %d (duration: %.2fms)",
+                         method, (int)ctx->status_code, duration_ms);
+    } else if (ctx->method == METHOD_FETCH) {
+        LOG_AT(LOG_SEVERITY_INFO, ctx->trace_id, ctx->span_id,
+               "Record fetched successfully (duration: %.2fms)", duration_ms);
+    } else {
+        LOG_AT(LOG_SEVERITY_INFO, ctx->trace_id, ctx->span_id,
+               "%s returned %zu records (duration: %.2fms)", method, ctx->record_count, duration_ms);
+    }
 
     /* Record metrics */
-    record_request_metrics(duration_ms);
+    request_metrics_record(ctx->table_name, ok ? REQUEST_STATUS_OK : REQUEST_STATUS_ERROR, duration_ms,
+                           exemplar_trace, exemplar_span);
 
     /* Export trace span */
-    if (g_trace_exporter != NULL) {
+    if (g_trace_exporter != NULL && ctx->sampled) {
         otlp_span_t span = {0};
-        span.trace_id = trace_id;
-        span.span_id = span_id;
-        span.parent_span_id = parent_span_id[0] ? parent_span_id : NULL;
-        span.name = "FetchLegacyData";
+        span.trace_id = ctx->trace_id;
+        span.span_id = ctx->span_id;
+        span.parent_span_id = ctx->has_parent ? ctx->parent_span_id : NULL;
+        span.name = method;
         span.kind = SPAN_KIND_SERVER;
-        span.start_time_nanos = start_time;
+        span.start_time_nanos = ctx->start_time;
         span.end_time_nanos = end_time;
-        span.status_code = SPAN_STATUS_OK;
+        span.status_code = ok ? SPAN_STATUS_OK : SPAN_STATUS_ERROR;
 
         /* Add attributes */
-        span_attribute_t attrs[4];
+        span_attribute_t attrs[5];
         attrs[0].key = "rpc.system";
         attrs[0].string_value = "grpc";
         attrs[1].key = "rpc.service";
         attrs[1].string_value = "grpcarch.ServiceF";
         attrs[2].key = "rpc.method";
-        attrs[2].string_value = "FetchLegacyData";
+        attrs[2].string_value = method;
         attrs[3].key = "db.table";
-        attrs[3].string_value = table_name;
+        attrs[3].string_value = ctx->table_name;
 
         span.attributes = attrs;
         span.attribute_count = 4;
 
+        /* Bulk calls also report how many records they returned */
+        char record_count[24];
+        if (ctx->method != METHOD_FETCH) {
+            snprintf(record_count, sizeof(record_count), "%zu", ctx->record_count);
+            attrs[4].key = "db.response.returned_rows";
+            attrs[4].string_value = record_count;
+            span.attribute_count = 5;
+        }
+
         otlp_export_span(g_trace_exporter, &span);
     }
 
-    /* Cleanup */
-    free(response_buf);
-    grpc_slice_unref(response_slice);
-    grpc_byte_buffer_destroy(response_bb);
-    grpc_metadata_array_destroy(&trailing_metadata);
-
-    if (request) {
-        grpcarch__legacy_data_request__free_unpacked(request, NULL);
+    end_stage(ctx, REQUEST_STAGE_TELEMETRY);
+    for (int stage = 0; stage < REQUEST_STAGE_COUNT; stage++) {
+        request_metrics_record_stage((request_stage_t)stage, ctx->stage_nanos[stage] / 1000000.0,
+                                     exemplar_trace, exemplar_span);
     }
 }
 
-/* Request a new call */
-static call_context_t* request_call(void) {
+/* Request a new call on a worker's completion queue */
+static call_context_t* request_call(server_worker_t *worker) {
     call_context_t *ctx = calloc(1, sizeof(call_context_t));
     if (!ctx) return NULL;
 
-    static int request_counter = 0;
-    ctx->request_id = ++request_counter;
+    ctx->state = CALL_STATE_REQUESTED;
+    ctx->worker = worker;
+    arena_init(&ctx->arena, CALL_ARENA_SIZE);
 
     grpc_metadata_array_init(&ctx->request_metadata);
     grpc_call_details_init(&ctx->call_details);
@@ -422,13 +989,15 @@ static call_context_t* request_call(void) {
         &ctx->call,
         &ctx->call_details,
         &ctx->request_metadata,
-        g_cq,
-        g_cq,
-        (void*)(intptr_t)ctx->request_id
+        worker->cq,
+        worker->cq,
+        ctx
     );
 
     if (err != GRPC_CALL_OK) {
-        fprintf(stderr, "[Service F] Error requesting call: %d\n", err);
+        LOG_RATE_LIMITED(10, LOG_SEVERITY_ERROR, NULL, NULL, "Error requesting call: %d", err);
+        grpc_metadata_array_destroy(&ctx->request_metadata);
+        grpc_call_details_destroy(&ctx->call_details);
         free(ctx);
         return NULL;
     }
@@ -448,117 +1017,241 @@ static void cleanup_call_context(call_context_t *ctx) {
     if (ctx->request_payload) {
         grpc_byte_buffer_destroy(ctx->request_payload);
     }
+    if (ctx->response_payload) {
+        grpc_byte_buffer_destroy(ctx->response_payload);
+    }
+    if (ctx->next_payload) {
+        grpc_byte_buffer_destroy(ctx->next_payload);
+    }
+    legacy_snapshot_release(ctx->snapshot);
+    /* Releases the unpacked request along with everything else it allocated */
+    arena_destroy(&ctx->arena);
     free(ctx);
 }
 
-/* Main server loop */
-static void run_server(const char *port) {
-    char server_address[256];
-    snprintf(server_address, sizeof(server_address), "0.0.0.0:%s", port);
+/* A new call has been matched to one of our pre-posted request slots */
+static void start_call(call_context_t *ctx) {
+    /* Match the full path; FetchLegacyData is a prefix of FetchLegacyDataBatch */
+    int method = 0;
+    while (method < METHOD_COUNT &&
+           grpc_slice_str_cmp(ctx->call_details.method, g_methods[method].path) != 0) {
+        method++;
+    }
 
-    grpc_init();
+    if (method < METHOD_COUNT) {
+        ctx->method = (call_method_t)method;
 
-    g_cq = grpc_completion_queue_create_for_next(NULL);
-    g_server = grpc_server_create(NULL, NULL);
+        /* Receive the message */
+        grpc_op ops[1];
+        memset(ops, 0, sizeof(ops));
 
-    grpc_server_credentials *creds = grpc_insecure_server_credentials_create();
-    int bound_port = grpc_server_add_http2_port(g_server, server_address, creds);
-    grpc_server_credentials_release(creds);
-    if (bound_port == 0) {
-        fprintf(stderr, "[Service F] Failed to bind to %s\n", server_address);
-        exit(1);
+        ops[0].op = GRPC_OP_RECV_MESSAGE;
+        ops[0].data.recv_message.recv_message = &ctx->request_payload;
+        ops[0].flags = 0;
+
+        ctx->state = CALL_STATE_RECEIVING;
+        grpc_call_error err = grpc_call_start_batch(ctx->call, ops, 1, ctx, NULL);
+        if (err != GRPC_CALL_OK) {
+            LOG_RATE_LIMITED(10, LOG_SEVERITY_ERROR, NULL, NULL, "Error receiving message: %d", err);
+            cleanup_call_context(ctx);
+        }
+    } else {
+        char *path = grpc_slice_to_c_string(ctx->call_details.method);
+        LOG_RATE_LIMITED(10, LOG_SEVERITY_WARN, NULL, NULL, "Unknown method: %s", path);
+        gpr_free(path);
+
+        /* Send UNIMPLEMENTED status */
+        start_send(ctx, GRPC_STATUS_UNIMPLEMENTED, "Method not implemented");
     }
+}
 
-    grpc_server_register_completion_queue(g_server, g_cq, NULL);
-    grpc_server_start(g_server);
+/* Advance a call's state machine after one of its batches completed */
+static void process_call_event(call_context_t *ctx, int success) {
+    switch (ctx->state) {
+        case CALL_STATE_REQUESTED:
+            if (!success) {
+                /* Server is shutting down; the slot was never matched */
+                cleanup_call_context(ctx);
+                return;
+            }
+            /* Keep the number of pre-posted slots on this CQ constant */
+            request_call(ctx->worker);
+            start_call(ctx);
+            break;
 
-    printf("[Service F] Server listening on %s\n", server_address);
-    printf("[Service F] Legacy data service (C) ready\n");
+        case CALL_STATE_RECEIVING:
+            if (!success) {
+                cleanup_call_context(ctx);
+                return;
+            }
+            handle_request(ctx);
+            break;
+
+        case CALL_STATE_DB_WAIT:
+            /* Timers are not CQ events; see run_due_timers() */
+            break;
+
+        case CALL_STATE_STREAMING:
+            if (!success) {
+                /* Client went away mid-stream */
+                cleanup_call_context(ctx);
+                return;
+            }
+            stream_next(ctx);
+            break;
 
-    /* Request first call */
-    call_context_t *pending_ctx = request_call();
+        case CALL_STATE_SENDING:
+            if (success && ctx->start_time != 0) {
+                complete_call(ctx);
+            }
+            cleanup_call_context(ctx);
+            break;
+    }
+}
+
+/* Fire every timer that is due; returns nanos until the next one (or max_wait) */
+static uint64_t run_due_timers(server_worker_t *worker, uint64_t max_wait) {
+    uint64_t now = get_monotonic_nanos();
+
+    while (worker->timer_count > 0 && worker->timers[0]->timer_due <= now) {
+        call_context_t *ctx = timer_heap_pop(worker);
+        finish_db_lookup(ctx);
+    }
+
+    if (worker->timer_count == 0) return max_wait;
+    uint64_t wait = worker->timers[0]->timer_due - now;
+    return wait < max_wait ? wait : max_wait;
+}
+
+/* Worker thread: pre-post request slots, then drive every call on this CQ */
+static void* worker_thread_func(void *arg) {
+    server_worker_t *worker = (server_worker_t*)arg;
+
+    for (int i = 0; i < g_pending_calls_per_worker; i++) {
+        request_call(worker);
+    }
 
     while (!g_shutdown) {
+        /* Sleep on the CQ no longer than the earliest pending timer */
+        uint64_t wait_nanos = run_due_timers(worker, 100 * 1000000ULL);
         gpr_timespec deadline = gpr_time_add(
-            gpr_now(GPR_CLOCK_REALTIME),
-            gpr_time_from_millis(100, GPR_TIMESPAN)
+            gpr_now(GPR_CLOCK_MONOTONIC),
+            gpr_time_from_nanos((int64_t)wait_nanos, GPR_TIMESPAN)
         );
 
-        grpc_event ev = grpc_completion_queue_next(g_cq, deadline, NULL);
+        grpc_event ev = grpc_completion_queue_next(worker->cq, deadline, NULL);
 
-        if (ev.type == GRPC_OP_COMPLETE && ev.success) {
-            if (ev.tag == (void*)(intptr_t)pending_ctx->request_id) {
-                /* New call received */
-                call_context_t *ctx = pending_ctx;
+        if (ev.type == GRPC_OP_COMPLETE) {
+            process_call_event((call_context_t*)ev.tag, ev.success);
+        } else if (ev.type == GRPC_QUEUE_SHUTDOWN) {
+            break;
+        }
+    }
 
-                /* Request next call immediately */
-                pending_ctx = request_call();
+    return NULL;
+}
 
-                /* Check the method being called */
-                char *method = grpc_slice_to_c_string(ctx->call_details.method);
+/* Read a positive integer from the environment */
+static int env_int(const char *name, int default_value) {
+    const char *value = getenv(name);
+    if (!value || !*value) return default_value;
+    int parsed = atoi(value);
+    return parsed > 0 ? parsed : default_value;
+}
 
-                if (strstr(method, "FetchLegacyData") != NULL) {
-                    /* Receive the message */
-                    grpc_op ops[1];
-                    memset(ops, 0, sizeof(ops));
+/* Read a ratio (0.0 - 1.0) from the environment */
+static double env_ratio(const char *name, double default_value) {
+    const char *value = getenv(name);
+    if (!value || !*value) return default_value;
+    char *end;
+    double parsed = strtod(value, &end);
+    if (*end != '\0' || parsed < 0.0 || parsed > 1.0) {
+        fprintf(stderr, "[Service F] Ignoring invalid %s=%s\n", name, value);
+        return default_value;
+    }
+    return parsed;
+}
 
-                    ops[0].op = GRPC_OP_RECV_MESSAGE;
-                    ops[0].data.recv_message.recv_message = &ctx->request_payload;
-                    ops[0].flags = 0;
+/* Main server loop */
+static void run_server(const char *port) {
+    char server_address[256];
+    snprintf(server_address, sizeof(server_address), "0.0.0.0:%s", port);
 
-                    grpc_call_start_batch(ctx->call, ops, 1, (void*)(intptr_t)1, NULL);
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    g_worker_count = env_int("SERVICE_F_WORKER_THREADS", cpus > 0 ? (int)cpus : 1);
+    if (g_worker_count > MAX_WORKER_THREADS) g_worker_count = MAX_WORKER_THREADS;
+    g_pending_calls_per_worker = env_int("SERVICE_F_PENDING_CALLS", DEFAULT_PENDING_CALLS_PER_WORKER);
+    g_trace_sample_ratio = env_ratio("SERVICE_F_TRACE_SAMPLE_RATIO", g_trace_sample_ratio);
+    /* Sets a level, not an algorithm: the core picks one the client's grpc-accept-encoding allows */
+    g_response_compression_bytes = (size_t)env_int("SERVICE_F_RESPONSE_COMPRESSION_BYTES", 0);
+    g_max_batch_records = (size_t)env_int("SERVICE_F_MAX_BATCH_RECORDS", DEFAULT_MAX_BATCH_RECORDS);
+    g_stream_chunk_bytes = (size_t)env_int("SERVICE_F_STREAM_CHUNK_BYTES", DEFAULT_STREAM_CHUNK_BYTES);
 
-                    /* Wait for message */
-                    grpc_event msg_ev;
-                    do {
-                        msg_ev = grpc_completion_queue_next(g_cq, gpr_inf_future(GPR_CLOCK_REALTIME), NULL);
-                    } while (msg_ev.type != GRPC_OP_COMPLETE || msg_ev.tag != (void*)(intptr_t)1);
+    grpc_init();
 
-                    /* Handle the request */
-                    handle_fetch_legacy_data(ctx);
-                } else {
-                    printf("[Service F] Unknown method: %s\n", method);
+    g_server = grpc_server_create(NULL, NULL);
 
-                    /* Send UNIMPLEMENTED status */
-                    grpc_op ops[2];
-                    memset(ops, 0, sizeof(ops));
+    grpc_server_credentials *creds = grpc_insecure_server_credentials_create();
+    int bound_port = grpc_server_add_http2_port(g_server, server_address, creds);
+    grpc_server_credentials_release(creds);
+    if (bound_port == 0) {
+        fprintf(stderr, "[Service F] Failed to bind to %s\n", server_address);
+        exit(1);
+    }
 
-                    ops[0].op = GRPC_OP_SEND_INITIAL_METADATA;
-                    ops[0].data.send_initial_metadata.count = 0;
+    /* One completion queue per worker; the server spreads new calls across them */
+    for (int i = 0; i < g_worker_count; i++) {
+        g_workers[i].index = i;
+        g_workers[i].cq = grpc_completion_queue_create_for_next(NULL);
+        grpc_server_register_completion_queue(g_server, g_workers[i].cq, NULL);
+    }
+    g_cq = g_workers[0].cq;
 
-                    ops[1].op = GRPC_OP_SEND_STATUS_FROM_SERVER;
-                    ops[1].data.send_status_from_server.status = GRPC_STATUS_UNIMPLEMENTED;
-                    grpc_slice status_details = grpc_slice_from_static_string("Method not implemented");
-                    ops[1].data.send_status_from_server.status_details = &status_details;
+    grpc_server_start(g_server);
 
-                    grpc_call_start_batch(ctx->call, ops, 2, (void*)(intptr_t)3, NULL);
+    printf("[Service F] Server listening on %s\n", server_address);
+    printf("[Service F] Worker threads: %d, pending calls per worker: %d\n",
+           g_worker_count, g_pending_calls_per_worker);
+    printf("[Service F] Legacy data service (C) ready\n");
 
-                    grpc_event status_ev;
-                    do {
-                        status_ev = grpc_completion_queue_next(g_cq, gpr_inf_future(GPR_CLOCK_REALTIME), NULL);
-                    } while (status_ev.type != GRPC_OP_COMPLETE || status_ev.tag != (void*)(intptr_t)3);
-                }
+    /* Worker 0 runs on this thread */
+    for (int i = 1; i < g_worker_count; i++) {
+        pthread_create(&g_workers[i].thread, NULL, worker_thread_func, &g_workers[i]);
+    }
+    worker_thread_func(&g_workers[0]);
 
-                gpr_free(method);
-                cleanup_call_context(ctx);
-            }
-        } else if (ev.type == GRPC_QUEUE_SHUTDOWN) {
-            break;
-        }
+    for (int i = 1; i < g_worker_count; i++) {
+        pthread_join(g_workers[i].thread, NULL);
     }
 
     /* Cleanup */
-    if (pending_ctx) {
-        cleanup_call_context(pending_ctx);
+    for (int i = 0; i < g_worker_count; i++) {
+        call_context_t *ctx;
+        while ((ctx = timer_heap_pop(&g_workers[i])) != NULL) {
+            cleanup_call_context(ctx);
+        }
+        free(g_workers[i].timers);
     }
 
     grpc_server_shutdown_and_notify(g_server, g_cq, NULL);
-    grpc_completion_queue_shutdown(g_cq);
+    grpc_server_cancel_all_calls(g_server);
 
-    /* Drain completion queue */
-    while (grpc_completion_queue_next(g_cq, gpr_inf_future(GPR_CLOCK_REALTIME), NULL).type != GRPC_QUEUE_SHUTDOWN);
+    for (int i = 0; i < g_worker_count; i++) {
+        grpc_completion_queue_shutdown(g_workers[i].cq);
+    }
+
+    /* Drain completion queues, releasing contexts still parked on them */
+    for (int i = 0; i < g_worker_count; i++) {
+        grpc_event ev;
+        while ((ev = grpc_completion_queue_next(g_workers[i].cq,
+                    gpr_inf_future(GPR_CLOCK_REALTIME), NULL)).type != GRPC_QUEUE_SHUTDOWN) {
+            if (ev.type == GRPC_OP_COMPLETE && ev.tag != NULL) {
+                cleanup_call_context((call_context_t*)ev.tag);
+            }
+        }
+        grpc_completion_queue_destroy(g_workers[i].cq);
+    }
 
-    grpc_completion_queue_destroy(g_cq);
     grpc_server_destroy(g_server);
     grpc_shutdown();
 }
@@ -570,43 +1263,66 @@ int main(int argc, char **argv) {
     const char *otel_endpoint = getenv("OTEL_EXPORTER_OTLP_ENDPOINT");
     const char *service_name = getenv("OTEL_SERVICE_NAME");
     if (!service_name) service_name = "service-f";
-    g_service_name = service_name;
-
-    /* Seed random number generator */
-    srand(time(NULL));
 
     printf("[Service F] Starting gRPC server...\n");
 
-    /* Initialize OTLP exporters */
+    /* Initialize OTLP exporters; all signals share one channel and thread */
     if (otel_endpoint) {
-        g_trace_exporter = otlp_exporter_create(otel_endpoint, service_name);
+        g_otlp_pipeline = otlp_pipeline_create(otel_endpoint);
+        if (!g_otlp_pipeline) {
+            fprintf(stderr, "[Service F] Warning: Failed to initialize OTLP pipeline\n");
+        }
+    }
+
+    if (g_otlp_pipeline) {
+        g_trace_exporter = otlp_exporter_create(g_otlp_pipeline, service_name);
         if (g_trace_exporter) {
             printf("[Service F] OTLP trace exporter initialized: %s\n", otel_endpoint);
         } else {
             fprintf(stderr, "[Service F] Warning: Failed to initialize OTLP trace exporter\n");
         }
 
-        g_log_exporter = otlp_log_exporter_create(otel_endpoint, service_name);
+        g_log_exporter = otlp_log_exporter_create(g_otlp_pipeline, service_name);
         if (g_log_exporter) {
             printf("[Service F] OTLP log exporter initialized: %s\n", otel_endpoint);
         } else {
             fprintf(stderr, "[Service F] Warning: Failed to initialize OTLP log exporter\n");
         }
 
-        g_metrics_exporter = otlp_metrics_exporter_create(otel_endpoint, service_name);
+        g_metrics_exporter = otlp_metrics_exporter_create(g_otlp_pipeline, service_name);
         if (g_metrics_exporter) {
             printf("[Service F] OTLP metrics exporter initialized: %s\n", otel_endpoint);
             /* Start metrics export thread */
+            g_metrics_start_nanos = get_time_nanos();
             pthread_create(&g_metrics_thread, NULL, metrics_export_thread, NULL);
         } else {
             fprintf(stderr, "[Service F] Warning: Failed to initialize OTLP metrics exporter\n");
         }
     }
 
+    /* Serve records from snapshot files when a store is configured */
+    const char *store_dir = getenv("SERVICE_F_LEGACY_STORE_DIR");
+    if (store_dir && *store_dir) {
+        g_legacy_store = legacy_store_open(
+            store_dir,
+            (unsigned)env_int("SERVICE_F_LEGACY_STORE_RELOAD_SECONDS", DEFAULT_STORE_RELOAD_SECONDS));
+        if (g_legacy_store) {
+            printf("[Service F] Legacy store: %s\n", store_dir);
+        } else {
+            fprintf(stderr, "[Service F] Warning: Failed to open legacy store %s, "
+                            "using the simulated backend\n", store_dir);
+        }
+    }
+
+    /* Request-path logs go through the async queue from here on */
+    async_log_start(g_log_exporter, service_name);
+
     run_server(port);
 
     /* Cleanup exporters */
     g_shutdown = 1;
+    async_log_stop();
+    legacy_store_close(g_legacy_store);
 
     /* Wait for metrics thread to finish */
     if (g_metrics_exporter) {
@@ -623,5 +1339,7 @@ int main(int argc, char **argv) {
         otlp_exporter_destroy(g_trace_exporter);
     }
 
+    otlp_pipeline_destroy(g_otlp_pipeline);
+
     return 0;
 }
@@ -0,0 +1,147 @@
+/*
+ * Bounded lock-free MPSC ring buffer
+ *
+ * Each cell carries a sequence number (Vyukov's bounded queue): a cell at
+ * position pos is free for producers when seq == pos, readable by the
+ * consumer when seq == pos + 1, and returned for the next lap by setting
+ * seq = pos + capacity.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE
+
+#include "mpsc_ring.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#define CACHE_LINE_SIZE 64
+
+/* Per-cell header, followed by the payload */
+typedef struct {
+    atomic_size_t seq;
+    size_t pos;         /* Claimed position, written by the owning producer */
+} ring_cell_t;
+
+#define CELL_HEADER_SIZE \
+    ((sizeof(ring_cell_t) + CACHE_LINE_SIZE - 1) & ~(size_t)(CACHE_LINE_SIZE - 1))
+
+struct mpsc_ring {
+    unsigned char *cells;
+    size_t stride;
+    size_t capacity;
+    size_t mask;
+
+    /* Producer and consumer cursors live on separate cache lines */
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t head;
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t tail;
+};
+
+static inline ring_cell_t* cell_at(const mpsc_ring_t *ring, size_t pos) {
+    return (ring_cell_t*)(ring->cells + (pos & ring->mask) * ring->stride);
+}
+
+static inline void* cell_payload(ring_cell_t *cell) {
+    return (unsigned char*)cell + CELL_HEADER_SIZE;
+}
+
+static inline ring_cell_t* payload_cell(void *payload) {
+    return (ring_cell_t*)((unsigned char*)payload - CELL_HEADER_SIZE);
+}
+
+mpsc_ring_t* mpsc_ring_create(size_t slot_size, size_t capacity) {
+    if (slot_size == 0 || capacity == 0) return NULL;
+
+    size_t rounded = 1;
+    while (rounded < capacity) rounded <<= 1;
+
+    mpsc_ring_t *ring = aligned_alloc(CACHE_LINE_SIZE, sizeof(mpsc_ring_t));
+    if (!ring) return NULL;
+    memset(ring, 0, sizeof(mpsc_ring_t));
+
+    ring->capacity = rounded;
+    ring->mask = rounded - 1;
+    ring->stride = (CELL_HEADER_SIZE + slot_size + CACHE_LINE_SIZE - 1) &
+                   ~(size_t)(CACHE_LINE_SIZE - 1);
+
+    ring->cells = aligned_alloc(CACHE_LINE_SIZE, ring->stride * rounded);
+    if (!ring->cells) {
+        free(ring);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < rounded; i++) {
+        ring_cell_t *cell = cell_at(ring, i);
+        atomic_init(&cell->seq, i);
+        cell->pos = 0;
+    }
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+
+    return ring;
+}
+
+void* mpsc_ring_reserve(mpsc_ring_t *ring) {
+    size_t pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    for (;;) {
+        ring_cell_t *cell = cell_at(ring, pos);
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ring->head, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                cell->pos = pos;
+                return cell_payload(cell);
+            }
+            /* pos was reloaded by the failed CAS */
+        } else if (diff < 0) {
+            /* Consumer has not released this cell yet: ring is full */
+            return NULL;
+        } else {
+            pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        }
+    }
+}
+
+void mpsc_ring_commit(mpsc_ring_t *ring, void *slot) {
+    (void)ring;
+    ring_cell_t *cell = payload_cell(slot);
+    atomic_store_explicit(&cell->seq, cell->pos + 1, memory_order_release);
+}
+
+void* mpsc_ring_peek(mpsc_ring_t *ring) {
+    size_t pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    ring_cell_t *cell = cell_at(ring, pos);
+    size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+
+    if (seq != pos + 1) return NULL;
+    return cell_payload(cell);
+}
+
+void mpsc_ring_release(mpsc_ring_t *ring) {
+    size_t pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    ring_cell_t *cell = cell_at(ring, pos);
+
+    atomic_store_explicit(&cell->seq, pos + ring->capacity, memory_order_release);
+    atomic_store_explicit(&ring->tail, pos + 1, memory_order_relaxed);
+}
+
+size_t mpsc_ring_size(const mpsc_ring_t *ring) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    return head >= tail ? head - tail : 0;
+}
+
+size_t mpsc_ring_capacity(const mpsc_ring_t *ring) {
+    return ring->capacity;
+}
+
+void mpsc_ring_destroy(mpsc_ring_t *ring) {
+    if (!ring) return;
+    free(ring->cells);
+    free(ring);
+}
@@ -0,0 +1,89 @@
+/*
+ * Bounded lock-free multi-producer/single-consumer ring buffer
+ *
+ * A preallocated array of fixed-size slots. Producers claim a slot with a
+ * single compare-and-swap, copy their payload into it and publish it; one
+ * consumer drains slots in order. No locks or allocations on either path.
+ */
+
+#ifndef MPSC_RING_H
+#define MPSC_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Opaque ring handle */
+typedef struct mpsc_ring mpsc_ring_t;
+
+/*
+ * Create a ring
+ *
+ * @param slot_size  Payload size of each slot in bytes
+ * @param capacity   Number of slots (rounded up to a power of two)
+ * @return  Ring handle, or NULL on failure
+ */
+mpsc_ring_t* mpsc_ring_create(size_t slot_size, size_t capacity);
+
+/*
+ * Reserve a slot for writing (any thread)
+ *
+ * @param ring  Ring handle
+ * @return  Pointer to slot_size writable bytes, or NULL if the ring is full
+ */
+void* mpsc_ring_reserve(mpsc_ring_t *ring);
+
+/*
+ * Publish a slot obtained from mpsc_ring_reserve() to the consumer
+ *
+ * @param ring  Ring handle
+ * @param slot  Pointer returned by mpsc_ring_reserve()
+ */
+void mpsc_ring_commit(mpsc_ring_t *ring, void *slot);
+
+/*
+ * Peek at the oldest published slot (consumer only)
+ *
+ * @param ring  Ring handle
+ * @return  Pointer to the slot payload, or NULL if nothing is ready
+ */
+void* mpsc_ring_peek(mpsc_ring_t *ring);
+
+/*
+ * Return the slot last returned by mpsc_ring_peek() to producers (consumer only)
+ *
+ * @param ring  Ring handle
+ */
+void mpsc_ring_release(mpsc_ring_t *ring);
+
+/*
+ * Approximate number of reserved-but-not-released slots
+ *
+ * @param ring  Ring handle
+ * @return  Current fill level
+ */
+size_t mpsc_ring_size(const mpsc_ring_t *ring);
+
+/*
+ * Ring capacity in slots
+ *
+ * @param ring  Ring handle
+ * @return  Capacity after power-of-two rounding
+ */
+size_t mpsc_ring_capacity(const mpsc_ring_t *ring);
+
+/*
+ * Destroy the ring and free its storage
+ *
+ * @param ring  Ring handle
+ */
+void mpsc_ring_destroy(mpsc_ring_t *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MPSC_RING_H */
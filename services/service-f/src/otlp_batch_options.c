@@ -0,0 +1,49 @@
+/*
+ * OTLP batch processor options
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE
+
+#include "otlp_batch_options.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_MAX_QUEUE_SIZE 2048
+#define DEFAULT_MAX_EXPORT_BATCH_SIZE 512
+#define DEFAULT_SCHEDULE_DELAY_MILLIS 1000
+#define DEFAULT_EXPORT_TIMEOUT_MILLIS 30000
+
+/* Read <prefix>_<name> as a positive integer */
+static unsigned long env_ulong(const char *prefix, const char *name, unsigned long default_value) {
+    char key[64];
+    snprintf(key, sizeof(key), "%s_%s", prefix, name);
+
+    const char *value = getenv(key);
+    if (!value || !*value) return default_value;
+
+    char *end;
+    unsigned long parsed = strtoul(value, &end, 10);
+    if (*end != '\0' || parsed == 0) {
+        fprintf(stderr, "[OTLP] Ignoring invalid %s=%s\n", key, value);
+        return default_value;
+    }
+    return parsed;
+}
+
+void otlp_batch_options_from_env(otlp_batch_options_t *options, const char *prefix) {
+    options->max_queue_size = env_ulong(prefix, "MAX_QUEUE_SIZE", DEFAULT_MAX_QUEUE_SIZE);
+    options->max_export_batch_size =
+        env_ulong(prefix, "MAX_EXPORT_BATCH_SIZE", DEFAULT_MAX_EXPORT_BATCH_SIZE);
+    options->schedule_delay_millis =
+        (uint32_t)env_ulong(prefix, "SCHEDULE_DELAY", DEFAULT_SCHEDULE_DELAY_MILLIS);
+    options->export_timeout_millis =
+        (uint32_t)env_ulong(prefix, "EXPORT_TIMEOUT", DEFAULT_EXPORT_TIMEOUT_MILLIS);
+
+    /* As in the SDK, a batch can never be larger than the queue */
+    if (options->max_export_batch_size > options->max_queue_size) {
+        options->max_export_batch_size = options->max_queue_size;
+    }
+}
@@ -0,0 +1,44 @@
+/*
+ * OTLP batch processor options
+ *
+ * Mirrors the OpenTelemetry SDK batch span / log record processor settings
+ * and reads them from the standard OTEL_BSP_* and OTEL_BLRP_* environment
+ * variables.
+ */
+
+#ifndef OTLP_BATCH_OPTIONS_H
+#define OTLP_BATCH_OPTIONS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Environment variable prefixes */
+#define OTLP_BATCH_SPAN_PREFIX "OTEL_BSP"
+#define OTLP_BATCH_LOG_PREFIX  "OTEL_BLRP"
+
+typedef struct {
+    size_t max_queue_size;          /* Records buffered before new ones are dropped */
+    size_t max_export_batch_size;   /* Records per Export call; reaching it triggers an export */
+    uint32_t schedule_delay_millis; /* Longest time a record waits before export */
+    uint32_t export_timeout_millis; /* Deadline for a single Export call */
+} otlp_batch_options_t;
+
+/*
+ * Fill options with defaults, then apply <prefix>_MAX_QUEUE_SIZE,
+ * <prefix>_MAX_EXPORT_BATCH_SIZE, <prefix>_SCHEDULE_DELAY and
+ * <prefix>_EXPORT_TIMEOUT from the environment
+ *
+ * @param options  Options to fill
+ * @param prefix   OTLP_BATCH_SPAN_PREFIX or OTLP_BATCH_LOG_PREFIX
+ */
+void otlp_batch_options_from_env(otlp_batch_options_t *options, const char *prefix);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OTLP_BATCH_OPTIONS_H */
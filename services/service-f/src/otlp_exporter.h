@@ -11,6 +11,9 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include "otlp_pipeline.h"
+#include "trace_context.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -40,9 +43,9 @@ typedef struct {
 
 /* Span data structure */
 typedef struct {
-    const char *trace_id;         /* 32-char hex string */
-    const char *span_id;          /* 16-char hex string */
-    const char *parent_span_id;   /* 16-char hex string, NULL if root */
+    const uint8_t *trace_id;        /* OTLP_TRACE_ID_SIZE bytes */
+    const uint8_t *span_id;         /* OTLP_SPAN_ID_SIZE bytes */
+    const uint8_t *parent_span_id;  /* OTLP_SPAN_ID_SIZE bytes, NULL if root */
     const char *name;             /* Span name */
     span_kind_t kind;
     uint64_t start_time_nanos;
@@ -60,18 +63,26 @@ typedef struct otlp_exporter otlp_exporter_t;
 /*
  * Create a new OTLP exporter
  *
- * @param endpoint  OTLP collector endpoint (e.g., "http://otel-collector:4317")
+ * Queue and batch limits come from the OTEL_BSP_* environment variables.
+ * Setting SERVICE_F_TRACE_TAIL_RATIO below 1 enables tail sampling (see
+ * tail_sampler.h); the other SERVICE_F_TRACE_TAIL_* variables tune it.
+ *
+ * @param pipeline  Pipeline that sends the exports (must outlive the exporter)
  * @param service_name  Name of this service for resource attributes
  * @return  Exporter handle, or NULL on failure
  */
-otlp_exporter_t* otlp_exporter_create(const char *endpoint, const char *service_name);
+otlp_exporter_t* otlp_exporter_create(otlp_pipeline_t *pipeline, const char *service_name);
 
 /*
  * Export a span to the collector
  *
+ * The span is copied into a preallocated lock-free queue slot; no locks
+ * or allocations are taken on the calling thread, except for waking the
+ * export thread once a full batch is queued.
+ *
  * @param exporter  Exporter handle
  * @param span      Span data to export
- * @return  0 on success, -1 on failure
+ * @return  0 on success, -1 on failure (including a full queue)
  */
 int otlp_export_span(otlp_exporter_t *exporter, const otlp_span_t *span);
 
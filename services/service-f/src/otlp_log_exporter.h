@@ -11,6 +11,9 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include "otlp_pipeline.h"
+#include "trace_context.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -34,8 +37,8 @@ typedef struct {
 
 /* Log record data structure */
 typedef struct {
-    const char *trace_id;         /* 32-char hex string, optional */
-    const char *span_id;          /* 16-char hex string, optional */
+    const uint8_t *trace_id;      /* OTLP_TRACE_ID_SIZE bytes, optional */
+    const uint8_t *span_id;       /* OTLP_SPAN_ID_SIZE bytes, optional */
     log_severity_t severity;
     const char *body;             /* Log message body */
     uint64_t timestamp_nanos;
@@ -50,11 +53,13 @@ typedef struct otlp_log_exporter otlp_log_exporter_t;
 /*
  * Create a new OTLP log exporter
  *
- * @param endpoint  OTLP collector endpoint (e.g., "http://otel-collector:4317")
+ * Queue and batch limits come from the OTEL_BLRP_* environment variables.
+ *
+ * @param pipeline  Pipeline that sends the exports (must outlive the exporter)
  * @param service_name  Name of this service for resource attributes
  * @return  Exporter handle, or NULL on failure
  */
-otlp_log_exporter_t* otlp_log_exporter_create(const char *endpoint, const char *service_name);
+otlp_log_exporter_t* otlp_log_exporter_create(otlp_pipeline_t *pipeline, const char *service_name);
 
 /*
  * Export a log record to the collector
@@ -11,6 +11,8 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include "otlp_pipeline.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -30,6 +32,7 @@ typedef struct {
 
 /* Data point for counters/gauges */
 typedef struct {
+    uint64_t start_time_nanos;      /* Start of the cumulative interval (counters) */
     uint64_t timestamp_nanos;
     union {
         int64_t int_value;
@@ -40,16 +43,27 @@ typedef struct {
     size_t attribute_count;
 } metric_data_point_t;
 
+/* Sample measurement linked to the trace it came from */
+typedef struct {
+    uint64_t timestamp_nanos;
+    double value;
+    const uint8_t *trace_id;        /* 16 bytes */
+    const uint8_t *span_id;         /* 8 bytes */
+} metric_exemplar_t;
+
 /* Histogram data point */
 typedef struct {
+    uint64_t start_time_nanos;      /* Start of the cumulative interval */
     uint64_t timestamp_nanos;
     uint64_t count;
     double sum;
-    double *bucket_counts;
-    double *explicit_bounds;
+    const uint64_t *bucket_counts;  /* bucket_count entries */
+    const double *explicit_bounds;  /* bucket_count - 1 entries */
     size_t bucket_count;
     metric_attribute_t *attributes;
     size_t attribute_count;
+    const metric_exemplar_t *exemplars;
+    size_t exemplar_count;
 } histogram_data_point_t;
 
 /* Metric definition */
@@ -74,19 +88,22 @@ typedef struct otlp_metrics_exporter otlp_metrics_exporter_t;
 /*
  * Create a new OTLP metrics exporter
  *
- * @param endpoint  OTLP collector endpoint (e.g., "http://otel-collector:4317")
+ * @param pipeline  Pipeline that sends the exports (must outlive the exporter)
  * @param service_name  Name of this service for resource attributes
  * @return  Exporter handle, or NULL on failure
  */
-otlp_metrics_exporter_t* otlp_metrics_exporter_create(const char *endpoint, const char *service_name);
+otlp_metrics_exporter_t* otlp_metrics_exporter_create(otlp_pipeline_t *pipeline, const char *service_name);
 
 /*
  * Export metrics to the collector
  *
+ * The request is serialized before returning, so the metrics array may be
+ * reused immediately; the Export call itself completes asynchronously.
+ *
  * @param exporter  Exporter handle
  * @param metrics   Array of metrics to export
  * @param count     Number of metrics
- * @return  0 on success, -1 on failure
+ * @return  0 if the export was started, -1 on failure
  */
 int otlp_export_metrics(otlp_metrics_exporter_t *exporter, const otlp_metric_t *metrics, size_t count);
 
@@ -0,0 +1,385 @@
+/*
+ * OTLP telemetry pipeline
+ *
+ * The pipeline thread blocks in grpc_completion_queue_next, bounded by the
+ * earliest signal schedule or retry. Export call completions arrive as
+ * transport slot tags; early-export and flush requests from other threads
+ * arrive as the pipeline's own wakeup tag.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE
+
+#include "otlp_pipeline.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#include <grpc/grpc.h>
+#include <grpc/compression.h>
+#include <grpc/grpc_security.h>
+#include <grpc/support/time.h>
+
+#include "otlp_transport.h"
+
+/* Longest idle wait of the pipeline thread */
+#define MAX_WAIT_NANOS 1000000000ULL
+
+struct otlp_signal {
+    otlp_pipeline_t *pipeline;
+    otlp_transport_t *transport;
+    otlp_signal_export_fn export_batch;
+    void *ctx;
+    uint64_t schedule_delay_nanos;
+
+    /* Scheduling state; protected by the pipeline mutex */
+    uint64_t next_due;              /* Monotonic nanos of the next scheduled export */
+    int backlog;                    /* Window filled up before the queue drained */
+    int flush_requested;
+    atomic_int export_requested;
+
+    otlp_signal_t *next;
+};
+
+struct otlp_pipeline {
+    char *host;
+    char *port;
+    grpc_channel *channel;
+    grpc_completion_queue *cq;
+
+    pthread_t thread;
+    atomic_int running;
+    atomic_int wakeup_pending;
+    char wakeup_tag;                /* Its address is the CQ tag for wakeups */
+
+    pthread_mutex_t mutex;          /* Protects the signal list and scheduling state */
+    pthread_cond_t flushed;
+    otlp_signal_t *signals;
+};
+
+/* Parse endpoint URL */
+static int parse_endpoint(const char *endpoint, char **host, char **port) {
+    const char *ptr = endpoint;
+
+    /* Skip http:// or https:// */
+    if (strncmp(ptr, "http://", 7) == 0) {
+        ptr += 7;
+    } else if (strncmp(ptr, "https://", 8) == 0) {
+        ptr += 8;
+    }
+
+    /* Find port separator */
+    const char *colon = strchr(ptr, ':');
+    if (colon) {
+        size_t host_len = colon - ptr;
+        *host = malloc(host_len + 1);
+        strncpy(*host, ptr, host_len);
+        (*host)[host_len] = '\0';
+
+        *port = strdup(colon + 1);
+    } else {
+        *host = strdup(ptr);
+        *port = strdup("4317");  /* Default OTLP gRPC port */
+    }
+
+    return 0;
+}
+
+static uint64_t monotonic_nanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* Post the wakeup tag to the pipeline's completion queue (any thread) */
+static void pipeline_wake(otlp_pipeline_t *pipeline) {
+    if (atomic_exchange_explicit(&pipeline->wakeup_pending, 1, memory_order_acq_rel)) return;
+
+    /*
+     * C core has no public call to post an event to a CQ. A connectivity
+     * watch with an already expired deadline completes at once and delivers
+     * the tag, which is all we need.
+     */
+    grpc_channel_watch_connectivity_state(pipeline->channel, GRPC_CHANNEL_SHUTDOWN,
+                                          gpr_now(GPR_CLOCK_MONOTONIC), pipeline->cq,
+                                          &pipeline->wakeup_tag);
+}
+
+/* Run due exports for every signal; returns nanos until the next deadline */
+static uint64_t service_signals(otlp_pipeline_t *pipeline) {
+    uint64_t next_wait = MAX_WAIT_NANOS;
+
+    pthread_mutex_lock(&pipeline->mutex);
+    uint64_t now = monotonic_nanos();
+
+    for (otlp_signal_t *signal = pipeline->signals; signal; signal = signal->next) {
+        uint64_t retry_wait = otlp_transport_run_retries(signal->transport);
+        if (retry_wait < next_wait) next_wait = retry_wait;
+
+        if (!signal->export_batch) continue;
+
+        int requested = atomic_exchange_explicit(&signal->export_requested, 0, memory_order_relaxed);
+        if (requested || signal->flush_requested || signal->backlog || now >= signal->next_due) {
+            signal->backlog = 0;
+
+            for (;;) {
+                if (otlp_transport_available(signal->transport) == 0) {
+                    /* Resume when a call completes */
+                    signal->backlog = 1;
+                    break;
+                }
+                if (signal->export_batch(signal->ctx) == 0) {
+                    if (signal->flush_requested) {
+                        signal->flush_requested = 0;
+                        pthread_cond_broadcast(&pipeline->flushed);
+                    }
+                    break;
+                }
+            }
+
+            signal->next_due = now + signal->schedule_delay_nanos;
+        }
+
+        uint64_t due_wait = signal->next_due > now ? signal->next_due - now : 0;
+        if (due_wait < next_wait) next_wait = due_wait;
+    }
+
+    pthread_mutex_unlock(&pipeline->mutex);
+    return next_wait;
+}
+
+/* Pipeline thread */
+static void* pipeline_thread_func(void *arg) {
+    otlp_pipeline_t *pipeline = (otlp_pipeline_t*)arg;
+    uint64_t wait_nanos = MAX_WAIT_NANOS;
+
+    while (atomic_load_explicit(&pipeline->running, memory_order_acquire)) {
+        gpr_timespec deadline = gpr_time_add(
+            gpr_now(GPR_CLOCK_MONOTONIC),
+            gpr_time_from_nanos((int64_t)wait_nanos, GPR_TIMESPAN)
+        );
+
+        grpc_event ev = grpc_completion_queue_next(pipeline->cq, deadline, NULL);
+        if (ev.type == GRPC_QUEUE_SHUTDOWN) break;
+
+        if (ev.type == GRPC_OP_COMPLETE) {
+            if (ev.tag == &pipeline->wakeup_tag) {
+                atomic_store_explicit(&pipeline->wakeup_pending, 0, memory_order_release);
+            } else {
+                otlp_transport_complete(ev.tag, ev.success);
+            }
+        }
+
+        wait_nanos = service_signals(pipeline);
+    }
+
+    return NULL;
+}
+
+/*
+ * Channel compression from OTEL_EXPORTER_OTLP_COMPRESSION ("gzip" or
+ * "none"). gRPC core has no zstd codec, so "zstd" falls back to gzip, the
+ * other codec the collector's receiver accepts.
+ */
+static grpc_compression_algorithm compression_from_env(void) {
+    const char *value = getenv("OTEL_EXPORTER_OTLP_COMPRESSION");
+    if (!value || !*value || strcasecmp(value, "none") == 0) return GRPC_COMPRESS_NONE;
+    if (strcasecmp(value, "gzip") == 0) return GRPC_COMPRESS_GZIP;
+    if (strcasecmp(value, "zstd") == 0) {
+        fprintf(stderr, "[OTLP] zstd compression is not supported by gRPC core, using gzip\n");
+        return GRPC_COMPRESS_GZIP;
+    }
+    fprintf(stderr, "[OTLP] Ignoring unknown OTEL_EXPORTER_OTLP_COMPRESSION=%s\n", value);
+    return GRPC_COMPRESS_NONE;
+}
+
+otlp_pipeline_t* otlp_pipeline_create(const char *endpoint) {
+    if (!endpoint) return NULL;
+
+    otlp_pipeline_t *pipeline = calloc(1, sizeof(otlp_pipeline_t));
+    if (!pipeline) return NULL;
+
+    if (parse_endpoint(endpoint, &pipeline->host, &pipeline->port) != 0) {
+        free(pipeline);
+        return NULL;
+    }
+
+    /* Initialize gRPC */
+    grpc_init();
+
+    /* One channel (one HTTP/2 connection) for every signal */
+    char target[256];
+    snprintf(target, sizeof(target), "%s:%s", pipeline->host, pipeline->port);
+
+    /* Every signal's Export calls are compressed with the channel default */
+    grpc_arg compression_arg;
+    compression_arg.type = GRPC_ARG_INTEGER;
+    compression_arg.key = (char*)GRPC_COMPRESSION_CHANNEL_DEFAULT_ALGORITHM;
+    compression_arg.value.integer = (int)compression_from_env();
+    grpc_channel_args channel_args = { 1, &compression_arg };
+
+    grpc_channel_credentials *creds = grpc_insecure_credentials_create();
+    pipeline->channel = grpc_channel_create(target, creds, &channel_args);
+    grpc_channel_credentials_release(creds);
+    if (!pipeline->channel) {
+        fprintf(stderr, "[OTLP] Failed to create channel to %s\n", target);
+        free(pipeline->host);
+        free(pipeline->port);
+        free(pipeline);
+        grpc_shutdown();
+        return NULL;
+    }
+
+    pipeline->cq = grpc_completion_queue_create_for_next(NULL);
+
+    pthread_mutex_init(&pipeline->mutex, NULL);
+
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&pipeline->flushed, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+
+    atomic_init(&pipeline->wakeup_pending, 0);
+    atomic_init(&pipeline->running, 1);
+    pthread_create(&pipeline->thread, NULL, pipeline_thread_func, pipeline);
+
+    return pipeline;
+}
+
+otlp_signal_t* otlp_pipeline_register(otlp_pipeline_t *pipeline, const char *method,
+                                      const char *log_prefix,
+                                      otlp_signal_export_fn export_batch, void *ctx,
+                                      uint32_t schedule_delay_millis,
+                                      uint32_t export_timeout_millis) {
+    if (!pipeline || !method) return NULL;
+
+    otlp_signal_t *signal = calloc(1, sizeof(otlp_signal_t));
+    if (!signal) return NULL;
+
+    signal->transport = otlp_transport_create(pipeline->channel, pipeline->cq, method, log_prefix,
+                                              OTLP_TRANSPORT_DEFAULT_MAX_IN_FLIGHT,
+                                              export_timeout_millis);
+    if (!signal->transport) {
+        free(signal);
+        return NULL;
+    }
+
+    signal->pipeline = pipeline;
+    signal->export_batch = export_batch;
+    signal->ctx = ctx;
+    signal->schedule_delay_nanos = (uint64_t)schedule_delay_millis * 1000000ULL;
+    signal->next_due = monotonic_nanos() + signal->schedule_delay_nanos;
+    atomic_init(&signal->export_requested, 0);
+
+    pthread_mutex_lock(&pipeline->mutex);
+    signal->next = pipeline->signals;
+    pipeline->signals = signal;
+    pthread_mutex_unlock(&pipeline->mutex);
+
+    /* Let the thread pick up the new schedule */
+    pipeline_wake(pipeline);
+
+    return signal;
+}
+
+void otlp_signal_request_export(otlp_signal_t *signal) {
+    /* Plain load first: producers above the threshold should not all write the flag */
+    if (atomic_load_explicit(&signal->export_requested, memory_order_relaxed)) return;
+    if (atomic_exchange_explicit(&signal->export_requested, 1, memory_order_relaxed)) return;
+    pipeline_wake(signal->pipeline);
+}
+
+int otlp_signal_send(otlp_signal_t *signal, grpc_slice request) {
+    return otlp_transport_send(signal->transport, request);
+}
+
+int otlp_signal_flush(otlp_signal_t *signal, uint32_t timeout_millis) {
+    if (!signal) return -1;
+
+    otlp_pipeline_t *pipeline = signal->pipeline;
+    uint64_t start = monotonic_nanos();
+
+    if (signal->export_batch) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += timeout_millis / 1000;
+        deadline.tv_nsec += (long)(timeout_millis % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+
+        pthread_mutex_lock(&pipeline->mutex);
+        signal->flush_requested = 1;
+        pipeline_wake(pipeline);
+
+        while (signal->flush_requested) {
+            if (pthread_cond_timedwait(&pipeline->flushed, &pipeline->mutex, &deadline) != 0) break;
+        }
+        int drained = !signal->flush_requested;
+        signal->flush_requested = 0;
+        pthread_mutex_unlock(&pipeline->mutex);
+
+        if (!drained) return -1;
+    }
+
+    /* Then wait for the calls the drain started */
+    uint64_t elapsed_millis = (monotonic_nanos() - start) / 1000000ULL;
+    uint32_t remaining = elapsed_millis < timeout_millis ? timeout_millis - (uint32_t)elapsed_millis : 0;
+    return otlp_transport_flush(signal->transport, remaining);
+}
+
+void otlp_pipeline_unregister(otlp_signal_t *signal) {
+    if (!signal) return;
+
+    otlp_pipeline_t *pipeline = signal->pipeline;
+
+    pthread_mutex_lock(&pipeline->mutex);
+    otlp_signal_t **link = &pipeline->signals;
+    while (*link && *link != signal) link = &(*link)->next;
+    if (*link) *link = signal->next;
+    pthread_mutex_unlock(&pipeline->mutex);
+
+    /* The pipeline thread keeps reaping while the transport cancels its calls */
+    otlp_transport_destroy(signal->transport);
+    free(signal);
+}
+
+void otlp_pipeline_destroy(otlp_pipeline_t *pipeline) {
+    if (!pipeline) return;
+
+    if (pipeline->signals) {
+        fprintf(stderr, "[OTLP] Destroying pipeline with registered signals\n");
+    }
+
+    /* Stop the thread */
+    atomic_store_explicit(&pipeline->running, 0, memory_order_release);
+    atomic_store_explicit(&pipeline->wakeup_pending, 0, memory_order_release);
+    pipeline_wake(pipeline);
+    pthread_join(pipeline->thread, NULL);
+
+    /* Cleanup gRPC */
+    grpc_completion_queue_shutdown(pipeline->cq);
+
+    grpc_event ev;
+    do {
+        ev = grpc_completion_queue_next(pipeline->cq, gpr_inf_future(GPR_CLOCK_REALTIME), NULL);
+    } while (ev.type != GRPC_QUEUE_SHUTDOWN);
+
+    grpc_completion_queue_destroy(pipeline->cq);
+    grpc_channel_destroy(pipeline->channel);
+    grpc_shutdown();
+
+    /* Free memory */
+    pthread_cond_destroy(&pipeline->flushed);
+    pthread_mutex_destroy(&pipeline->mutex);
+    free(pipeline->host);
+    free(pipeline->port);
+    free(pipeline);
+}
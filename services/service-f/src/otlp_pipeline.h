@@ -0,0 +1,115 @@
+/*
+ * OTLP telemetry pipeline
+ *
+ * One channel, one completion queue and one thread shared by every signal
+ * (traces, logs, metrics) sent to the same collector. Exporters register a
+ * signal with an export callback; the pipeline thread calls it on the
+ * signal's schedule, when a producer requests an early export, and on
+ * flush, and reaps the resulting Export calls.
+ */
+
+#ifndef OTLP_PIPELINE_H
+#define OTLP_PIPELINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <grpc/slice.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Opaque handles */
+typedef struct otlp_pipeline otlp_pipeline_t;
+typedef struct otlp_signal otlp_signal_t;
+
+/*
+ * Export callback, run on the pipeline thread
+ *
+ * Serializes at most one batch of queued telemetry and passes it to
+ * otlp_signal_send(). Only called while the signal has a free in-flight
+ * slot.
+ *
+ * @param ctx  Context passed to otlp_pipeline_register()
+ * @return  Number of records exported, 0 once the queue is empty
+ */
+typedef size_t (*otlp_signal_export_fn)(void *ctx);
+
+/*
+ * Create a pipeline and start its thread
+ *
+ * Exports are compressed when OTEL_EXPORTER_OTLP_COMPRESSION is "gzip".
+ *
+ * @param endpoint  OTLP collector endpoint (e.g., "http://otel-collector:4317")
+ * @return  Pipeline handle, or NULL on failure
+ */
+otlp_pipeline_t* otlp_pipeline_create(const char *endpoint);
+
+/*
+ * Register a signal on the pipeline
+ *
+ * @param pipeline               Pipeline handle
+ * @param method                 Fully qualified Export method
+ * @param log_prefix             Prefix for error messages, e.g. "[OTLP-LOGS]"
+ * @param export_batch           Export callback, or NULL if the signal only
+ *                               sends from its own threads
+ * @param ctx                    Context for the callback
+ * @param schedule_delay_millis  Interval between scheduled exports
+ * @param export_timeout_millis  Deadline for a single Export call
+ * @return  Signal handle, or NULL on failure
+ */
+otlp_signal_t* otlp_pipeline_register(otlp_pipeline_t *pipeline, const char *method,
+                                      const char *log_prefix,
+                                      otlp_signal_export_fn export_batch, void *ctx,
+                                      uint32_t schedule_delay_millis,
+                                      uint32_t export_timeout_millis);
+
+/*
+ * Ask the pipeline thread to export this signal now (any thread)
+ *
+ * @param signal  Signal handle
+ */
+void otlp_signal_request_export(otlp_signal_t *signal);
+
+/*
+ * Start an Export call for a serialized request
+ *
+ * From the export callback this never blocks; from other threads it waits
+ * for a free in-flight slot. Takes ownership of the slice reference.
+ *
+ * @param signal   Signal handle
+ * @param request  Serialized Export*ServiceRequest
+ * @return  0 if the call was started, -1 on failure
+ */
+int otlp_signal_send(otlp_signal_t *signal, grpc_slice request);
+
+/*
+ * Export everything queued for the signal and wait for the calls to finish
+ *
+ * @param signal          Signal handle
+ * @param timeout_millis  Longest time to wait
+ * @return  0 on success, -1 on timeout
+ */
+int otlp_signal_flush(otlp_signal_t *signal, uint32_t timeout_millis);
+
+/*
+ * Remove a signal from the pipeline, cancelling its outstanding calls
+ *
+ * @param signal  Signal handle
+ */
+void otlp_pipeline_unregister(otlp_signal_t *signal);
+
+/*
+ * Stop the pipeline thread and release the channel; all signals must have
+ * been unregistered
+ *
+ * @param pipeline  Pipeline handle
+ */
+void otlp_pipeline_destroy(otlp_pipeline_t *pipeline);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OTLP_PIPELINE_H */
@@ -0,0 +1,372 @@
+/*
+ * OTLP export transport
+ *
+ * Calls live in a fixed pool of max_in_flight slots, and each slot is used
+ * directly as the completion queue tag. A slot is FREE, IN_FLIGHT (a batch
+ * is outstanding on the CQ) or BACKOFF (waiting for its retry time). The
+ * thread draining the CQ bounds its wait by otlp_transport_run_retries(),
+ * so retries never block other calls.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE
+
+#include "otlp_transport.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include <grpc/support/alloc.h>
+#include <grpc/support/time.h>
+#include <grpc/byte_buffer.h>
+
+/* Retry policy for UNAVAILABLE / RESOURCE_EXHAUSTED */
+#define MAX_ATTEMPTS 5
+#define INITIAL_BACKOFF_MILLIS 100
+#define MAX_BACKOFF_MILLIS 5000
+
+typedef enum {
+    EXPORT_CALL_FREE = 0,
+    EXPORT_CALL_IN_FLIGHT,
+    EXPORT_CALL_BACKOFF
+} export_call_state_t;
+
+/* One Export call, reused across attempts and requests */
+typedef struct {
+    otlp_transport_t *transport;
+    export_call_state_t state;
+    grpc_slice request;             /* Kept for retries */
+    int attempt;
+    uint64_t retry_at;              /* Monotonic nanos, BACKOFF only */
+
+    /* Per-attempt gRPC state */
+    grpc_call *call;
+    grpc_byte_buffer *request_bb;
+    grpc_byte_buffer *response_bb;
+    grpc_metadata_array initial_metadata;
+    grpc_metadata_array trailing_metadata;
+    grpc_status_code status;
+    grpc_slice status_details;
+} export_call_t;
+
+struct otlp_transport {
+    grpc_channel *channel;
+    grpc_completion_queue *cq;
+    grpc_slice method;
+    char *log_prefix;
+    uint32_t timeout_millis;
+
+    /* Slot pool; protected by mutex */
+    export_call_t *calls;
+    size_t max_in_flight;
+    size_t active;                  /* Slots that are not FREE */
+    int shutting_down;
+    unsigned int jitter_seed;
+    pthread_mutex_t mutex;
+    pthread_cond_t slot_freed;
+};
+
+static uint64_t monotonic_nanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void deadline_after_millis(struct timespec *ts, uint32_t millis) {
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    ts->tv_sec += millis / 1000;
+    ts->tv_nsec += (long)(millis % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+/* Release the gRPC resources of the last attempt */
+static void release_attempt(export_call_t *c) {
+    grpc_slice_unref(c->status_details);
+    grpc_metadata_array_destroy(&c->initial_metadata);
+    grpc_metadata_array_destroy(&c->trailing_metadata);
+    if (c->response_bb) {
+        grpc_byte_buffer_destroy(c->response_bb);
+        c->response_bb = NULL;
+    }
+    grpc_byte_buffer_destroy(c->request_bb);
+    c->request_bb = NULL;
+    if (c->call) {
+        grpc_call_unref(c->call);
+        c->call = NULL;
+    }
+}
+
+/* Return a slot to the pool; caller holds the mutex */
+static void release_slot(otlp_transport_t *t, export_call_t *c) {
+    grpc_slice_unref(c->request);
+    c->request = grpc_empty_slice();
+    c->state = EXPORT_CALL_FREE;
+    t->active--;
+    pthread_cond_broadcast(&t->slot_freed);
+}
+
+/* Start one attempt of the call in slot c; caller holds the mutex */
+static int start_attempt(otlp_transport_t *t, export_call_t *c) {
+    gpr_timespec deadline = gpr_time_add(
+        gpr_now(GPR_CLOCK_REALTIME),
+        gpr_time_from_millis(t->timeout_millis, GPR_TIMESPAN)
+    );
+
+    c->call = grpc_channel_create_call(
+        t->channel,
+        NULL,
+        GRPC_PROPAGATE_DEFAULTS,
+        t->cq,
+        t->method,
+        NULL,  /* host */
+        deadline,
+        NULL
+    );
+    if (!c->call) {
+        fprintf(stderr, "%s Failed to create call\n", t->log_prefix);
+        return -1;
+    }
+
+    c->request_bb = grpc_raw_byte_buffer_create(&c->request, 1);
+    c->response_bb = NULL;
+    c->status_details = grpc_empty_slice();
+    grpc_metadata_array_init(&c->initial_metadata);
+    grpc_metadata_array_init(&c->trailing_metadata);
+
+    grpc_op ops[6];
+    memset(ops, 0, sizeof(ops));
+
+    ops[0].op = GRPC_OP_SEND_INITIAL_METADATA;
+    ops[0].data.send_initial_metadata.count = 0;
+
+    ops[1].op = GRPC_OP_SEND_MESSAGE;
+    ops[1].data.send_message.send_message = c->request_bb;
+
+    ops[2].op = GRPC_OP_SEND_CLOSE_FROM_CLIENT;
+
+    ops[3].op = GRPC_OP_RECV_INITIAL_METADATA;
+    ops[3].data.recv_initial_metadata.recv_initial_metadata = &c->initial_metadata;
+
+    ops[4].op = GRPC_OP_RECV_MESSAGE;
+    ops[4].data.recv_message.recv_message = &c->response_bb;
+
+    ops[5].op = GRPC_OP_RECV_STATUS_ON_CLIENT;
+    ops[5].data.recv_status_on_client.trailing_metadata = &c->trailing_metadata;
+    ops[5].data.recv_status_on_client.status = &c->status;
+    ops[5].data.recv_status_on_client.status_details = &c->status_details;
+
+    grpc_call_error err = grpc_call_start_batch(c->call, ops, 6, c, NULL);
+    if (err != GRPC_CALL_OK) {
+        fprintf(stderr, "%s Failed to start batch: %d\n", t->log_prefix, err);
+        release_attempt(c);
+        return -1;
+    }
+
+    c->state = EXPORT_CALL_IN_FLIGHT;
+    return 0;
+}
+
+/* Exponential backoff with jitter in [delay/2, delay) */
+static uint64_t backoff_nanos(otlp_transport_t *t, int attempt) {
+    uint64_t delay_millis = INITIAL_BACKOFF_MILLIS;
+    for (int i = 1; i < attempt && delay_millis < MAX_BACKOFF_MILLIS; i++) {
+        delay_millis *= 2;
+    }
+    if (delay_millis > MAX_BACKOFF_MILLIS) delay_millis = MAX_BACKOFF_MILLIS;
+
+    uint64_t half = delay_millis / 2;
+    uint64_t jittered = half + (uint64_t)rand_r(&t->jitter_seed) % (half ? half : 1);
+    return jittered * 1000000ULL;
+}
+
+void otlp_transport_complete(void *tag, int success) {
+    export_call_t *c = (export_call_t*)tag;
+    otlp_transport_t *t = c->transport;
+
+    pthread_mutex_lock(&t->mutex);
+
+    int retry = 0;
+    if (!success) {
+        fprintf(stderr, "%s Export call failed\n", t->log_prefix);
+    } else if (c->status != GRPC_STATUS_OK) {
+        retry = (c->status == GRPC_STATUS_UNAVAILABLE ||
+                 c->status == GRPC_STATUS_RESOURCE_EXHAUSTED) &&
+                c->attempt < MAX_ATTEMPTS && !t->shutting_down;
+
+        if (!retry) {
+            char *details = grpc_slice_to_c_string(c->status_details);
+            fprintf(stderr, "%s Export failed: %d - %s\n", t->log_prefix, c->status, details);
+            gpr_free(details);
+        }
+    }
+
+    release_attempt(c);
+
+    if (retry) {
+        c->state = EXPORT_CALL_BACKOFF;
+        c->retry_at = monotonic_nanos() + backoff_nanos(t, c->attempt);
+        c->attempt++;
+    } else {
+        release_slot(t, c);
+    }
+
+    pthread_mutex_unlock(&t->mutex);
+}
+
+uint64_t otlp_transport_run_retries(otlp_transport_t *t) {
+    uint64_t next_wait = UINT64_MAX;
+
+    pthread_mutex_lock(&t->mutex);
+    uint64_t now = monotonic_nanos();
+
+    for (size_t i = 0; i < t->max_in_flight; i++) {
+        export_call_t *c = &t->calls[i];
+        if (c->state != EXPORT_CALL_BACKOFF) continue;
+
+        if (c->retry_at <= now) {
+            if (t->shutting_down || start_attempt(t, c) != 0) {
+                release_slot(t, c);
+            }
+        } else if (c->retry_at - now < next_wait) {
+            next_wait = c->retry_at - now;
+        }
+    }
+
+    pthread_mutex_unlock(&t->mutex);
+    return next_wait;
+}
+
+otlp_transport_t* otlp_transport_create(grpc_channel *channel, grpc_completion_queue *cq,
+                                        const char *method, const char *log_prefix,
+                                        size_t max_in_flight, uint32_t timeout_millis) {
+    if (!channel || !cq || !method || max_in_flight == 0) return NULL;
+
+    otlp_transport_t *t = calloc(1, sizeof(otlp_transport_t));
+    if (!t) return NULL;
+
+    t->calls = calloc(max_in_flight, sizeof(export_call_t));
+    if (!t->calls) {
+        free(t);
+        return NULL;
+    }
+    for (size_t i = 0; i < max_in_flight; i++) {
+        t->calls[i].transport = t;
+        t->calls[i].request = grpc_empty_slice();
+    }
+
+    t->channel = channel;
+    t->method = grpc_slice_from_copied_string(method);
+    t->log_prefix = strdup(log_prefix ? log_prefix : "[OTLP]");
+    t->timeout_millis = timeout_millis;
+    t->max_in_flight = max_in_flight;
+    t->jitter_seed = (unsigned int)monotonic_nanos();
+    t->cq = cq;
+
+    pthread_mutex_init(&t->mutex, NULL);
+
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&t->slot_freed, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+
+    return t;
+}
+
+int otlp_transport_send(otlp_transport_t *t, grpc_slice request) {
+    if (!t) {
+        grpc_slice_unref(request);
+        return -1;
+    }
+
+    pthread_mutex_lock(&t->mutex);
+
+    /* Backpressure: wait for a free slot in the window */
+    while (t->active == t->max_in_flight && !t->shutting_down) {
+        pthread_cond_wait(&t->slot_freed, &t->mutex);
+    }
+    if (t->shutting_down) {
+        pthread_mutex_unlock(&t->mutex);
+        grpc_slice_unref(request);
+        return -1;
+    }
+
+    export_call_t *c = NULL;
+    for (size_t i = 0; i < t->max_in_flight; i++) {
+        if (t->calls[i].state == EXPORT_CALL_FREE) {
+            c = &t->calls[i];
+            break;
+        }
+    }
+
+    c->request = request;
+    c->attempt = 1;
+    t->active++;
+
+    int result = start_attempt(t, c);
+    if (result != 0) {
+        release_slot(t, c);
+    }
+
+    pthread_mutex_unlock(&t->mutex);
+    return result;
+}
+
+size_t otlp_transport_available(otlp_transport_t *t) {
+    pthread_mutex_lock(&t->mutex);
+    size_t available = t->shutting_down ? 0 : t->max_in_flight - t->active;
+    pthread_mutex_unlock(&t->mutex);
+    return available;
+}
+
+int otlp_transport_flush(otlp_transport_t *t, uint32_t timeout_millis) {
+    if (!t) return -1;
+
+    struct timespec deadline;
+    deadline_after_millis(&deadline, timeout_millis);
+
+    pthread_mutex_lock(&t->mutex);
+    while (t->active > 0) {
+        if (pthread_cond_timedwait(&t->slot_freed, &t->mutex, &deadline) != 0) break;
+    }
+    int result = t->active == 0 ? 0 : -1;
+    pthread_mutex_unlock(&t->mutex);
+
+    return result;
+}
+
+void otlp_transport_destroy(otlp_transport_t *t) {
+    if (!t) return;
+
+    /* Abandon pending retries and cancel what is still on the wire */
+    pthread_mutex_lock(&t->mutex);
+    t->shutting_down = 1;
+    for (size_t i = 0; i < t->max_in_flight; i++) {
+        export_call_t *c = &t->calls[i];
+        if (c->state == EXPORT_CALL_BACKOFF) {
+            release_slot(t, c);
+        } else if (c->state == EXPORT_CALL_IN_FLIGHT) {
+            grpc_call_cancel(c->call, NULL);
+        }
+    }
+    pthread_cond_broadcast(&t->slot_freed);
+
+    /* Cancelled calls still complete through the completion queue */
+    while (t->active > 0) {
+        pthread_cond_wait(&t->slot_freed, &t->mutex);
+    }
+    pthread_mutex_unlock(&t->mutex);
+
+    grpc_slice_unref(t->method);
+    pthread_cond_destroy(&t->slot_freed);
+    pthread_mutex_destroy(&t->mutex);
+    free(t->log_prefix);
+    free(t->calls);
+    free(t);
+}
@@ -0,0 +1,103 @@
+/*
+ * OTLP export transport
+ *
+ * Issues unary OTLP Export calls asynchronously on a completion queue owned
+ * by the caller (see otlp_pipeline.h). Up to a fixed number of calls are
+ * kept in flight; UNAVAILABLE / RESOURCE_EXHAUSTED responses are retried
+ * with exponential backoff.
+ */
+
+#ifndef OTLP_TRANSPORT_H
+#define OTLP_TRANSPORT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <grpc/grpc.h>
+#include <grpc/slice.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Default number of concurrent Export calls per transport */
+#define OTLP_TRANSPORT_DEFAULT_MAX_IN_FLIGHT 4
+
+/* Opaque transport handle */
+typedef struct otlp_transport otlp_transport_t;
+
+/*
+ * Create a transport
+ *
+ * @param channel         Channel to the collector (not owned)
+ * @param cq              Completion queue the calls complete on (not owned)
+ * @param method          Fully qualified Export method, e.g. "/...TraceService/Export"
+ * @param log_prefix      Prefix for error messages, e.g. "[OTLP]"
+ * @param max_in_flight   Size of the in-flight window
+ * @param timeout_millis  Deadline for each attempt
+ * @return  Transport handle, or NULL on failure
+ */
+otlp_transport_t* otlp_transport_create(grpc_channel *channel, grpc_completion_queue *cq,
+                                        const char *method, const char *log_prefix,
+                                        size_t max_in_flight, uint32_t timeout_millis);
+
+/*
+ * Start an Export call for a serialized request
+ *
+ * Blocks while the in-flight window is full, so it must not be called from
+ * the thread that drains the completion queue unless
+ * otlp_transport_available() is non-zero. The transport takes ownership of
+ * the slice reference in all cases.
+ *
+ * @param transport  Transport handle
+ * @param request    Serialized Export*ServiceRequest
+ * @return  0 if the call was started, -1 on failure
+ */
+int otlp_transport_send(otlp_transport_t *transport, grpc_slice request);
+
+/*
+ * Number of free slots in the in-flight window
+ *
+ * @param transport  Transport handle
+ * @return  Calls that can be started without blocking
+ */
+size_t otlp_transport_available(otlp_transport_t *transport);
+
+/*
+ * Handle a completion queue event for one of the transport's calls
+ *
+ * @param tag      ev.tag of the event
+ * @param success  ev.success of the event
+ */
+void otlp_transport_complete(void *tag, int success);
+
+/*
+ * Restart calls whose backoff has elapsed (completion queue thread)
+ *
+ * @param transport  Transport handle
+ * @return  Nanoseconds until the next pending retry, or UINT64_MAX if none
+ */
+uint64_t otlp_transport_run_retries(otlp_transport_t *transport);
+
+/*
+ * Wait until every started call has finished, including retries
+ *
+ * @param transport       Transport handle
+ * @param timeout_millis  Longest time to wait
+ * @return  0 if the transport is idle, -1 on timeout
+ */
+int otlp_transport_flush(otlp_transport_t *transport, uint32_t timeout_millis);
+
+/*
+ * Cancel outstanding calls, wait for their completions and free the
+ * transport; the completion queue must still be serviced meanwhile
+ *
+ * @param transport  Transport handle
+ */
+void otlp_transport_destroy(otlp_transport_t *transport);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OTLP_TRANSPORT_H */
@@ -0,0 +1,241 @@
+/*
+ * Protobuf wire-format writer
+ *
+ * otlp_wire_begin() reserves a single byte for the length, which covers
+ * the small messages (attributes, status, resource) exactly; longer
+ * messages are shifted up by the extra length bytes when they are closed.
+ * That memmove is over the message's own bytes only, so encoding a request
+ * stays linear in its size.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE
+
+#include "otlp_wire.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Wire types */
+#define WIRE_VARINT 0
+#define WIRE_I64 1
+#define WIRE_LEN 2
+
+#define MAX_VARINT_SIZE 10
+
+static size_t varint_size(uint64_t value) {
+    size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+static size_t put_varint(uint8_t *out, uint64_t value) {
+    size_t i = 0;
+    while (value >= 0x80) {
+        out[i++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[i++] = (uint8_t)value;
+    return i;
+}
+
+/* Make room for n more bytes */
+static int reserve(otlp_wire_t *w, size_t n) {
+    if (w->failed) return -1;
+    if (w->len + n <= w->cap) return 0;
+
+    size_t cap = w->cap ? w->cap * 2 : (w->size_hint ? w->size_hint : 1024);
+    while (cap < w->len + n) cap *= 2;
+
+    uint8_t *data = realloc(w->data, cap);
+    if (!data) {
+        w->failed = 1;
+        return -1;
+    }
+    w->data = data;
+    w->cap = cap;
+    return 0;
+}
+
+static inline void put_tag(otlp_wire_t *w, uint32_t field, uint32_t wire_type) {
+    w->len += put_varint(w->data + w->len, ((uint64_t)field << 3) | wire_type);
+}
+
+static inline void put_fixed64(uint8_t *out, uint64_t value) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy(out, &value, sizeof(value));
+#else
+    for (int i = 0; i < 8; i++) out[i] = (uint8_t)(value >> (8 * i));
+#endif
+}
+
+void otlp_wire_init(otlp_wire_t *w, size_t size_hint) {
+    memset(w, 0, sizeof(*w));
+    w->size_hint = size_hint;
+}
+
+void otlp_wire_destroy(otlp_wire_t *w) {
+    free(w->data);
+    memset(w, 0, sizeof(*w));
+}
+
+void otlp_wire_varint_field(otlp_wire_t *w, uint32_t field, uint64_t value) {
+    if (reserve(w, 2 * MAX_VARINT_SIZE) != 0) return;
+    put_tag(w, field, WIRE_VARINT);
+    w->len += put_varint(w->data + w->len, value);
+}
+
+void otlp_wire_fixed64_field(otlp_wire_t *w, uint32_t field, uint64_t value) {
+    if (reserve(w, MAX_VARINT_SIZE + 8) != 0) return;
+    put_tag(w, field, WIRE_I64);
+    put_fixed64(w->data + w->len, value);
+    w->len += 8;
+}
+
+void otlp_wire_double_field(otlp_wire_t *w, uint32_t field, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    otlp_wire_fixed64_field(w, field, bits);
+}
+
+void otlp_wire_bytes_field(otlp_wire_t *w, uint32_t field, const void *data, size_t len) {
+    if (reserve(w, 2 * MAX_VARINT_SIZE + len) != 0) return;
+    put_tag(w, field, WIRE_LEN);
+    w->len += put_varint(w->data + w->len, len);
+    if (len > 0) memcpy(w->data + w->len, data, len);
+    w->len += len;
+}
+
+void otlp_wire_string_field(otlp_wire_t *w, uint32_t field, const char *value) {
+    if (!value || !*value) return;
+    otlp_wire_bytes_field(w, field, value, strlen(value));
+}
+
+void otlp_wire_packed_fixed64_field(otlp_wire_t *w, uint32_t field, const uint64_t *values, size_t count) {
+    if (count == 0) return;
+    size_t len = count * 8;
+    if (reserve(w, 2 * MAX_VARINT_SIZE + len) != 0) return;
+    put_tag(w, field, WIRE_LEN);
+    w->len += put_varint(w->data + w->len, len);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy(w->data + w->len, values, len);
+#else
+    for (size_t i = 0; i < count; i++) put_fixed64(w->data + w->len + i * 8, values[i]);
+#endif
+    w->len += len;
+}
+
+void otlp_wire_packed_double_field(otlp_wire_t *w, uint32_t field, const double *values, size_t count) {
+    /* Doubles are fixed64 on the wire */
+    otlp_wire_packed_fixed64_field(w, field, (const uint64_t*)(const void*)values, count);
+}
+
+void otlp_wire_string_attribute(otlp_wire_t *w, uint32_t field, const char *key, const char *value) {
+    size_t key_len = key ? strlen(key) : 0;
+    size_t value_len = value ? strlen(value) : 0;
+
+    /* Sizes are known up front, so nothing needs backpatching */
+    size_t any_len = 1 + varint_size(value_len) + value_len;
+    size_t kv_len = (key_len > 0 ? 1 + varint_size(key_len) + key_len : 0) +
+                    1 + varint_size(any_len) + any_len;
+
+    if (reserve(w, MAX_VARINT_SIZE + varint_size(kv_len) + kv_len) != 0) return;
+    put_tag(w, field, WIRE_LEN);
+    w->len += put_varint(w->data + w->len, kv_len);
+    if (key_len > 0) {
+        put_tag(w, 1, WIRE_LEN);                        /* KeyValue.key */
+        w->len += put_varint(w->data + w->len, key_len);
+        memcpy(w->data + w->len, key, key_len);
+        w->len += key_len;
+    }
+    put_tag(w, 2, WIRE_LEN);                            /* KeyValue.value */
+    w->len += put_varint(w->data + w->len, any_len);
+    put_tag(w, 1, WIRE_LEN);                            /* AnyValue.string_value */
+    w->len += put_varint(w->data + w->len, value_len);
+    if (value_len > 0) memcpy(w->data + w->len, value, value_len);
+    w->len += value_len;
+}
+
+void otlp_wire_raw(otlp_wire_t *w, const void *data, size_t len) {
+    if (len == 0 || reserve(w, len) != 0) return;
+    memcpy(w->data + w->len, data, len);
+    w->len += len;
+}
+
+size_t otlp_wire_begin(otlp_wire_t *w, uint32_t field) {
+    if (reserve(w, MAX_VARINT_SIZE + 1) != 0) return 0;
+    put_tag(w, field, WIRE_LEN);
+    return w->len++;
+}
+
+void otlp_wire_end(otlp_wire_t *w, size_t mark) {
+    if (w->failed) return;
+
+    size_t body_len = w->len - mark - 1;
+    size_t len_size = varint_size(body_len);
+    if (len_size > 1) {
+        if (reserve(w, len_size - 1) != 0) return;
+        memmove(w->data + mark + len_size, w->data + mark + 1, body_len);
+        w->len += len_size - 1;
+    }
+    put_varint(w->data + mark, body_len);
+}
+
+int otlp_wire_prefix_init(otlp_wire_prefix_t *prefix, const char *service_name) {
+    otlp_wire_init(&prefix->resource, 128);
+    otlp_wire_init(&prefix->scope, 64);
+
+    /* Resource {attributes: [service.name]} */
+    size_t mark = otlp_wire_begin(&prefix->resource, 1);
+    otlp_wire_string_attribute(&prefix->resource, 1, "service.name", service_name);
+    otlp_wire_end(&prefix->resource, mark);
+
+    /* InstrumentationScope {name, version} */
+    mark = otlp_wire_begin(&prefix->scope, 1);
+    otlp_wire_string_field(&prefix->scope, 1, "service-f-c");
+    otlp_wire_string_field(&prefix->scope, 2, "1.0.0");
+    otlp_wire_end(&prefix->scope, mark);
+
+    if (prefix->resource.failed || prefix->scope.failed) {
+        otlp_wire_prefix_destroy(prefix);
+        return -1;
+    }
+    return 0;
+}
+
+void otlp_wire_prefix_destroy(otlp_wire_prefix_t *prefix) {
+    otlp_wire_destroy(&prefix->resource);
+    otlp_wire_destroy(&prefix->scope);
+}
+
+void otlp_wire_open_scope(otlp_wire_t *w, const otlp_wire_prefix_t *prefix, size_t marks[2]) {
+    marks[0] = otlp_wire_begin(w, 1);                   /* Request.resource_* */
+    otlp_wire_raw(w, prefix->resource.data, prefix->resource.len);
+    marks[1] = otlp_wire_begin(w, 2);                   /* Resource*.scope_* */
+    otlp_wire_raw(w, prefix->scope.data, prefix->scope.len);
+}
+
+void otlp_wire_close_scope(otlp_wire_t *w, const size_t marks[2]) {
+    otlp_wire_end(w, marks[1]);
+    otlp_wire_end(w, marks[0]);
+}
+
+int otlp_wire_take_slice(otlp_wire_t *w, grpc_slice *out) {
+    if (w->failed || !w->data) {
+        free(w->data);
+        w->data = NULL;
+        w->len = w->cap = 0;
+        w->failed = 0;
+        return -1;
+    }
+
+    /* The slice frees the buffer once gRPC is done with it */
+    *out = grpc_slice_new(w->data, w->len, free);
+    w->size_hint = w->cap;
+    w->data = NULL;
+    w->len = w->cap = 0;
+    return 0;
+}
@@ -0,0 +1,155 @@
+/*
+ * Protobuf wire-format writer for OTLP export requests
+ *
+ * Exporters stream their records straight into a growing buffer instead
+ * of building a protobuf-c message tree and packing it. Nested messages
+ * are opened with otlp_wire_begin(), which reserves room for the length,
+ * and closed with otlp_wire_end(), which backpatches it. The request's
+ * Resource and InstrumentationScope never change, so they are encoded once
+ * per exporter (otlp_wire_prefix_t) and copied into every request.
+ *
+ * Every writer is a no-op once an allocation has failed; the failure is
+ * reported by otlp_wire_take_slice().
+ */
+
+#ifndef OTLP_WIRE_H
+#define OTLP_WIRE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <grpc/slice.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Output buffer */
+typedef struct {
+    uint8_t *data;
+    size_t len;
+    size_t cap;
+    size_t size_hint;  /* Capacity to start the next buffer with after a take */
+    int failed;
+} otlp_wire_t;
+
+/* Resource and scope fields shared by every request of one exporter */
+typedef struct {
+    otlp_wire_t resource;  /* Resource {service.name} as field 1 */
+    otlp_wire_t scope;     /* InstrumentationScope {name, version} as field 1 */
+} otlp_wire_prefix_t;
+
+/*
+ * Initialize an empty writer
+ *
+ * @param w          Writer
+ * @param size_hint  Initial capacity, allocated on first write
+ */
+void otlp_wire_init(otlp_wire_t *w, size_t size_hint);
+
+/*
+ * Free the writer's buffer
+ *
+ * @param w  Writer
+ */
+void otlp_wire_destroy(otlp_wire_t *w);
+
+/* Scalar fields; proto3 defaults are written too, callers skip them */
+void otlp_wire_varint_field(otlp_wire_t *w, uint32_t field, uint64_t value);
+void otlp_wire_fixed64_field(otlp_wire_t *w, uint32_t field, uint64_t value);
+void otlp_wire_double_field(otlp_wire_t *w, uint32_t field, double value);
+
+/* Length-delimited fields; string fields with a NULL or empty value are skipped */
+void otlp_wire_bytes_field(otlp_wire_t *w, uint32_t field, const void *data, size_t len);
+void otlp_wire_string_field(otlp_wire_t *w, uint32_t field, const char *value);
+
+/* Packed repeated fields */
+void otlp_wire_packed_fixed64_field(otlp_wire_t *w, uint32_t field, const uint64_t *values, size_t count);
+void otlp_wire_packed_double_field(otlp_wire_t *w, uint32_t field, const double *values, size_t count);
+
+/*
+ * KeyValue {key, AnyValue {string_value}} as a message field
+ *
+ * @param w      Writer
+ * @param field  Field number of the KeyValue in the enclosing message
+ * @param key    Attribute key
+ * @param value  String value (NULL is written as "")
+ */
+void otlp_wire_string_attribute(otlp_wire_t *w, uint32_t field, const char *key, const char *value);
+
+/*
+ * Append pre-encoded bytes
+ *
+ * @param w     Writer
+ * @param data  Encoded fields
+ * @param len   Length of data
+ */
+void otlp_wire_raw(otlp_wire_t *w, const void *data, size_t len);
+
+/*
+ * Open a nested message field
+ *
+ * @param w      Writer
+ * @param field  Field number of the message
+ * @return  Mark to pass to otlp_wire_end()
+ */
+size_t otlp_wire_begin(otlp_wire_t *w, uint32_t field);
+
+/*
+ * Close the message opened at mark, writing its length; messages must be
+ * closed innermost first
+ *
+ * @param w     Writer
+ * @param mark  Value returned by otlp_wire_begin()
+ */
+void otlp_wire_end(otlp_wire_t *w, size_t mark);
+
+/*
+ * Encode the shared resource and scope fields
+ *
+ * @param prefix        Prefix to fill in
+ * @param service_name  Value of the service.name resource attribute
+ * @return  0 on success, -1 on allocation failure
+ */
+int otlp_wire_prefix_init(otlp_wire_prefix_t *prefix, const char *service_name);
+
+/*
+ * Free a prefix
+ *
+ * @param prefix  Prefix from otlp_wire_prefix_init()
+ */
+void otlp_wire_prefix_destroy(otlp_wire_prefix_t *prefix);
+
+/*
+ * Open Resource{Spans,Logs,Metrics} {resource, Scope* {scope, ...}} as field
+ * 1 of an Export request; the records go in field 2 of the scope message
+ *
+ * @param w       Writer
+ * @param prefix  Encoded resource and scope
+ * @param marks   Receives the marks for otlp_wire_close_scope()
+ */
+void otlp_wire_open_scope(otlp_wire_t *w, const otlp_wire_prefix_t *prefix, size_t marks[2]);
+
+/*
+ * Close the messages opened by otlp_wire_open_scope()
+ *
+ * @param w      Writer
+ * @param marks  Marks from otlp_wire_open_scope()
+ */
+void otlp_wire_close_scope(otlp_wire_t *w, const size_t marks[2]);
+
+/*
+ * Hand the encoded request to gRPC without copying; the writer starts
+ * over with an empty buffer sized after this one
+ *
+ * @param w    Writer
+ * @param out  Receives the request slice
+ * @return  0 on success, -1 if an allocation failed while encoding
+ */
+int otlp_wire_take_slice(otlp_wire_t *w, grpc_slice *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OTLP_WIRE_H */
@@ -0,0 +1,208 @@
+/*
+ * LegacyRecord response encoder
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE
+
+#include "record_encoder.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <grpc/slice.h>
+
+/* Wire types */
+#define WIRE_VARINT 0
+#define WIRE_LEN 2
+
+#define MAX_VARINT_SIZE 10
+
+/* First head buffer; grows by doubling */
+#define INITIAL_HEAD_SIZE 4096
+
+/* LegacyRecord field numbers */
+#define RECORD_FIELD_ID 1
+#define RECORD_FIELD_RAW_DATA 2
+#define RECORD_FIELD_CREATED_AT 3
+#define RECORD_FIELD_UPDATED_AT 4
+
+static size_t varint_size(uint64_t value) {
+    size_t size = 1;
+    for (; value >= 0x80; value >>= 7) size++;
+    return size;
+}
+
+static void put_varint(record_encoder_t *enc, uint64_t value) {
+    while (value >= 0x80) {
+        enc->head[enc->head_len++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    enc->head[enc->head_len++] = (uint8_t)value;
+}
+
+static void put_tag(record_encoder_t *enc, uint32_t field, uint32_t wire_type) {
+    put_varint(enc, ((uint64_t)field << 3) | wire_type);
+}
+
+static void put_bytes(record_encoder_t *enc, const void *data, size_t len) {
+    if (len > 0) memcpy(enc->head + enc->head_len, data, len);
+    enc->head_len += len;
+}
+
+/* Make room for n more head bytes */
+static int reserve(record_encoder_t *enc, size_t n) {
+    if (enc->failed) return -1;
+    if (enc->head_len + n <= enc->head_cap) return 0;
+
+    size_t cap = enc->head_cap ? enc->head_cap * 2 : INITIAL_HEAD_SIZE;
+    while (cap < enc->head_len + n) cap *= 2;
+
+    uint8_t *head = realloc(enc->head, cap);
+    if (!head) {
+        enc->failed = 1;
+        return -1;
+    }
+    enc->head = head;
+    enc->head_cap = cap;
+    return 0;
+}
+
+static int push_segment(record_encoder_t *enc, const uint8_t *raw, size_t offset, size_t len) {
+    if (enc->segment_count == enc->segment_cap) {
+        size_t cap = enc->segment_cap ? enc->segment_cap * 2 : 16;
+        record_segment_t *segments = realloc(enc->segments, cap * sizeof(record_segment_t));
+        if (!segments) {
+            enc->failed = 1;
+            return -1;
+        }
+        enc->segments = segments;
+        enc->segment_cap = cap;
+    }
+    enc->segments[enc->segment_count++] = (record_segment_t){ raw, offset, len };
+    return 0;
+}
+
+/* Close the current run of head bytes */
+static int flush_head(record_encoder_t *enc) {
+    if (enc->head_len == enc->head_mark) return 0;
+    if (push_segment(enc, NULL, enc->head_mark, enc->head_len - enc->head_mark) != 0) return -1;
+    enc->head_mark = enc->head_len;
+    return 0;
+}
+
+void record_encoder_init(record_encoder_t *enc, legacy_snapshot_t *snapshot) {
+    memset(enc, 0, sizeof(*enc));
+    enc->snapshot = snapshot;
+}
+
+void record_encoder_destroy(record_encoder_t *enc) {
+    free(enc->head);
+    free(enc->segments);
+    memset(enc, 0, sizeof(*enc));
+}
+
+uint8_t* record_encoder_field(record_encoder_t *enc, uint32_t field, size_t len) {
+    if (reserve(enc, 2 * MAX_VARINT_SIZE + len) != 0) return NULL;
+
+    size_t start = enc->head_len;
+    put_tag(enc, field, WIRE_LEN);
+    put_varint(enc, len);
+    uint8_t *out = enc->head + enc->head_len;
+    enc->head_len += len;
+    enc->size += enc->head_len - start;
+    return out;
+}
+
+void record_encoder_bytes(record_encoder_t *enc, uint32_t field, const void *data, size_t len) {
+    uint8_t *out = record_encoder_field(enc, field, len);
+    if (out && len > 0) memcpy(out, data, len);
+}
+
+void record_encoder_record(record_encoder_t *enc, uint32_t field, const legacy_record_t *record,
+                           const uint8_t *trailer, size_t trailer_len) {
+    uint64_t created_at = (uint64_t)record->created_at;
+    uint64_t updated_at = (uint64_t)record->updated_at;
+    int zero_copy = enc->snapshot && record->raw_len >= RECORD_ENCODER_ZERO_COPY_BYTES;
+
+    /* proto3 defaults are left out, as protobuf-c would */
+    size_t body_len = trailer_len;
+    if (record->id_len > 0) body_len += 1 + varint_size(record->id_len) + record->id_len;
+    if (created_at != 0) body_len += 1 + varint_size(created_at);
+    if (updated_at != 0) body_len += 1 + varint_size(updated_at);
+    if (record->raw_len > 0) body_len += 1 + varint_size(record->raw_len) + record->raw_len;
+
+    size_t head_bytes = body_len - (zero_copy ? record->raw_len : 0);
+    if (reserve(enc, 2 * MAX_VARINT_SIZE + head_bytes) != 0) return;
+
+    size_t start = enc->head_len;
+    put_tag(enc, field, WIRE_LEN);
+    put_varint(enc, body_len);
+
+    if (record->id_len > 0) {
+        put_tag(enc, RECORD_FIELD_ID, WIRE_LEN);
+        put_varint(enc, record->id_len);
+        put_bytes(enc, record->id, record->id_len);
+    }
+    if (created_at != 0) {
+        put_tag(enc, RECORD_FIELD_CREATED_AT, WIRE_VARINT);
+        put_varint(enc, created_at);
+    }
+    if (updated_at != 0) {
+        put_tag(enc, RECORD_FIELD_UPDATED_AT, WIRE_VARINT);
+        put_varint(enc, updated_at);
+    }
+    put_bytes(enc, trailer, trailer_len);
+
+    /* raw_data goes last so a referenced value splits the head only once */
+    if (record->raw_len > 0) {
+        put_tag(enc, RECORD_FIELD_RAW_DATA, WIRE_LEN);
+        put_varint(enc, record->raw_len);
+        if (zero_copy) {
+            if (flush_head(enc) != 0 || push_segment(enc, record->raw_data, 0, record->raw_len) != 0) {
+                return;
+            }
+        } else {
+            put_bytes(enc, record->raw_data, record->raw_len);
+        }
+    }
+    enc->size += enc->head_len - start + (zero_copy ? record->raw_len : 0);
+}
+
+grpc_byte_buffer* record_encoder_finish(record_encoder_t *enc) {
+    grpc_byte_buffer *buffer = NULL;
+    if (enc->failed || flush_head(enc) != 0) goto out;
+
+    grpc_slice *slices = malloc((enc->segment_count ? enc->segment_count : 1) * sizeof(grpc_slice));
+    if (!slices) goto out;
+
+    /* The head slice owns the buffer; head segments are sub-slices of it */
+    grpc_slice head = enc->head ? grpc_slice_new(enc->head, enc->head_len, free) : grpc_empty_slice();
+    enc->head = NULL;
+
+    for (size_t i = 0; i < enc->segment_count; i++) {
+        record_segment_t *segment = &enc->segments[i];
+        if (segment->raw) {
+            legacy_snapshot_retain(enc->snapshot);
+            slices[i] = grpc_slice_new_with_user_data((void*)segment->raw, segment->len,
+                                                      legacy_snapshot_release, enc->snapshot);
+        } else {
+            slices[i] = grpc_slice_sub(head, segment->offset, segment->offset + segment->len);
+        }
+    }
+
+    buffer = grpc_raw_byte_buffer_create(slices, enc->segment_count);
+    for (size_t i = 0; i < enc->segment_count; i++) grpc_slice_unref(slices[i]);
+    grpc_slice_unref(head);
+    free(slices);
+
+out:
+    /* Start over with an empty response for the same snapshot */
+    free(enc->head);
+    enc->head = NULL;
+    enc->head_len = enc->head_cap = enc->head_mark = 0;
+    enc->segment_count = 0;
+    enc->size = 0;
+    enc->failed = 0;
+    return buffer;
+}
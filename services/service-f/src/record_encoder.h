@@ -0,0 +1,128 @@
+/*
+ * LegacyRecord response encoder
+ *
+ * Writes FetchLegacyData, FetchLegacyDataBatch and StreamLegacyData
+ * responses straight into a byte buffer. Large raw_data values from the
+ * legacy store are not copied: the buffer gets a slice over the snapshot
+ * mapping, holding a snapshot reference until gRPC has sent it. Everything
+ * else, and small raw_data values, is copied into one contiguous head
+ * buffer that the other slices are cut from.
+ *
+ * Protobuf allows a message's fields in any order, which lets callers
+ * write a response's status after its records, once the counts are known.
+ */
+
+#ifndef RECORD_ENCODER_H
+#define RECORD_ENCODER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <grpc/byte_buffer.h>
+
+#include "legacy_store.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* raw_data at least this long is referenced in the mapping instead of copied */
+#define RECORD_ENCODER_ZERO_COPY_BYTES 1024
+
+/* A run of the response: head bytes, or raw_data in the mapping */
+typedef struct {
+    const uint8_t *raw;     /* NULL for head bytes */
+    size_t offset;          /* Into the head buffer, when raw is NULL */
+    size_t len;
+} record_segment_t;
+
+typedef struct {
+    legacy_snapshot_t *snapshot;   /* Borrowed; NULL copies every raw_data */
+
+    uint8_t *head;
+    size_t head_len;
+    size_t head_cap;
+    size_t head_mark;       /* Head bytes before this are covered by segments */
+
+    record_segment_t *segments;
+    size_t segment_count;
+    size_t segment_cap;
+
+    size_t size;            /* Encoded bytes, head and mapping together */
+    int failed;
+} record_encoder_t;
+
+/*
+ * Start an empty response
+ *
+ * @param enc       Encoder
+ * @param snapshot  Snapshot the records come from, or NULL; the encoder
+ *                  takes its own references for the slices it creates
+ */
+void record_encoder_init(record_encoder_t *enc, legacy_snapshot_t *snapshot);
+
+/*
+ * Free whatever record_encoder_finish() did not take over
+ *
+ * @param enc  Encoder
+ */
+void record_encoder_destroy(record_encoder_t *enc);
+
+/*
+ * Reserve a length-delimited field for the caller to fill in, e.g. with a
+ * protobuf-c pack function
+ *
+ * @param enc    Encoder
+ * @param field  Field number
+ * @param len    Exact length of the field's contents
+ * @return  Where to write len bytes, or NULL on allocation failure
+ */
+uint8_t* record_encoder_field(record_encoder_t *enc, uint32_t field, size_t len);
+
+/*
+ * Append a string or bytes field
+ *
+ * @param enc    Encoder
+ * @param field  Field number
+ * @param data   Contents
+ * @param len    Length of data
+ */
+void record_encoder_bytes(record_encoder_t *enc, uint32_t field, const void *data, size_t len);
+
+/*
+ * Append a LegacyRecord message field
+ *
+ * @param enc          Encoder
+ * @param field        Field number of the record in the enclosing message
+ * @param record       Record; raw_data must lie in the encoder's snapshot
+ *                     if it has one
+ * @param trailer      Pre-encoded LegacyRecord fields appended to every
+ *                     record (the fields map), or NULL
+ * @param trailer_len  Length of trailer
+ */
+void record_encoder_record(record_encoder_t *enc, uint32_t field, const legacy_record_t *record,
+                           const uint8_t *trailer, size_t trailer_len);
+
+/*
+ * Bytes encoded so far
+ *
+ * @param enc  Encoder
+ * @return  Encoded size, including referenced raw_data
+ */
+static inline size_t record_encoder_size(const record_encoder_t *enc) {
+    return enc->size;
+}
+
+/*
+ * Hand the response over as a byte buffer; the encoder starts over empty
+ *
+ * @param enc  Encoder
+ * @return  Byte buffer, or NULL if an allocation failed while encoding
+ */
+grpc_byte_buffer* record_encoder_finish(record_encoder_t *enc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RECORD_ENCODER_H */
@@ -0,0 +1,312 @@
+/*
+ * Request metrics without a shared lock
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE
+
+#include "request_metrics.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Recording threads beyond this many are not counted */
+#define MAX_SHARDS 256
+#define CACHE_LINE_SIZE 64
+
+/* Attempts to read an exemplar that its writer keeps replacing */
+#define EXEMPLAR_READ_ATTEMPTS 4
+
+const double request_metrics_bounds[REQUEST_METRICS_BOUND_COUNT] = {
+    1, 2, 5, 10, 15, 20, 30, 50, 75, 100, 250, 500, 1000
+};
+
+const double request_metrics_stage_bounds[REQUEST_METRICS_BOUND_COUNT] = {
+    0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 25, 50, 100
+};
+
+/*
+ * Slowest sample of one interval, guarded by a sequence counter: the owning
+ * thread makes it odd while rewriting the fields, and a reader retries if
+ * it saw an odd or changed value
+ */
+typedef struct {
+    atomic_uint seq;
+    atomic_uint_fast64_t epoch;     /* Interval the sample belongs to */
+    atomic_uint_fast64_t value_nanos;
+    atomic_uint_fast64_t time_nanos;
+    atomic_uint_fast64_t trace_id[OTLP_TRACE_ID_SIZE / 8];
+    atomic_uint_fast64_t span_id;
+} exemplar_slot_t;
+
+typedef struct {
+    atomic_uint_fast64_t buckets[REQUEST_METRICS_BUCKET_COUNT];
+    atomic_uint_fast64_t sum_nanos;
+    exemplar_slot_t exemplar;
+} histogram_t;
+
+/* One thread's counters; only that thread writes to it */
+typedef struct {
+    atomic_size_t table_count;      /* names[0..table_count) are published */
+    char names[REQUEST_METRICS_MAX_TABLES][REQUEST_METRICS_TABLE_NAME_SIZE];
+    /* Per table and status; the last table is REQUEST_METRICS_OTHER_TABLE */
+    histogram_t tables[REQUEST_METRICS_MAX_TABLES + 1][REQUEST_STATUS_COUNT];
+    histogram_t stages[REQUEST_STAGE_COUNT];
+} shard_t;
+
+static _Atomic(shard_t*) g_shards[MAX_SHARDS];
+static atomic_size_t g_shard_count;
+static _Thread_local shard_t *t_shard;
+
+/* Current exemplar interval; advanced by every collection. Starts at 1 so
+   zeroed slots never look current. */
+static atomic_uint_fast64_t g_epoch = 1;
+
+const char* request_status_name(request_status_t status) {
+    return status == REQUEST_STATUS_OK ? "ok" : "error";
+}
+
+const char* request_stage_name(request_stage_t stage) {
+    switch (stage) {
+        case REQUEST_STAGE_PARSE: return "parse";
+        case REQUEST_STAGE_DB: return "db";
+        case REQUEST_STAGE_RESPOND: return "respond";
+        case REQUEST_STAGE_SEND: return "send";
+        case REQUEST_STAGE_TELEMETRY: return "telemetry";
+        default: return "unknown";
+    }
+}
+
+/* First use on a thread: allocate its shard and publish it to the collector */
+static shard_t* register_shard(void) {
+    size_t index = atomic_fetch_add_explicit(&g_shard_count, 1, memory_order_relaxed);
+    if (index >= MAX_SHARDS) {
+        if (index == MAX_SHARDS) {
+            fprintf(stderr, "[Service F] More than %d threads record metrics; ignoring the rest\n",
+                    MAX_SHARDS);
+        }
+        return NULL;
+    }
+
+    /* Aligned, padded allocation so no two shards share a cache line */
+    size_t size = (sizeof(shard_t) + CACHE_LINE_SIZE - 1) & ~(size_t)(CACHE_LINE_SIZE - 1);
+    shard_t *shard = aligned_alloc(CACHE_LINE_SIZE, size);
+    if (!shard) return NULL;
+    memset(shard, 0, size);
+
+    atomic_store_explicit(&g_shards[index], shard, memory_order_release);
+    t_shard = shard;
+    return shard;
+}
+
+/* Single-writer increment: no locked instruction needed */
+static inline void bump(atomic_uint_fast64_t *counter, uint64_t delta) {
+    atomic_store_explicit(counter,
+                          atomic_load_explicit(counter, memory_order_relaxed) + delta,
+                          memory_order_relaxed);
+}
+
+static inline uint64_t load_relaxed(atomic_uint_fast64_t *value) {
+    return atomic_load_explicit(value, memory_order_relaxed);
+}
+
+static inline void store_relaxed(atomic_uint_fast64_t *value, uint64_t v) {
+    atomic_store_explicit(value, v, memory_order_relaxed);
+}
+
+/* Keep this sample if it is the interval's first or slowest so far */
+static void offer_exemplar(exemplar_slot_t *slot, uint64_t value_nanos,
+                           const uint8_t *trace_id, const uint8_t *span_id) {
+    uint64_t epoch = atomic_load_explicit(&g_epoch, memory_order_relaxed);
+    if (load_relaxed(&slot->epoch) == epoch && value_nanos <= load_relaxed(&slot->value_nanos)) return;
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    unsigned seq = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+    atomic_store_explicit(&slot->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    uint64_t words[OTLP_TRACE_ID_SIZE / 8];
+    memcpy(words, trace_id, sizeof(words));
+    for (size_t i = 0; i < OTLP_TRACE_ID_SIZE / 8; i++) store_relaxed(&slot->trace_id[i], words[i]);
+    uint64_t span_word;
+    memcpy(&span_word, span_id, sizeof(span_word));
+    store_relaxed(&slot->span_id, span_word);
+    store_relaxed(&slot->value_nanos, value_nanos);
+    store_relaxed(&slot->time_nanos, (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+    store_relaxed(&slot->epoch, epoch);
+
+    atomic_store_explicit(&slot->seq, seq + 2, memory_order_release);
+}
+
+/* Copy out a slot's sample if it belongs to the given interval */
+static int read_exemplar(exemplar_slot_t *slot, uint64_t epoch, request_metrics_exemplar_t *out) {
+    for (int attempt = 0; attempt < EXEMPLAR_READ_ATTEMPTS; attempt++) {
+        unsigned before = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        if (before & 1) continue;
+
+        uint64_t words[OTLP_TRACE_ID_SIZE / 8];
+        for (size_t i = 0; i < OTLP_TRACE_ID_SIZE / 8; i++) words[i] = load_relaxed(&slot->trace_id[i]);
+        uint64_t span_word = load_relaxed(&slot->span_id);
+        uint64_t value_nanos = load_relaxed(&slot->value_nanos);
+        uint64_t time_nanos = load_relaxed(&slot->time_nanos);
+        uint64_t slot_epoch = load_relaxed(&slot->epoch);
+
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&slot->seq, memory_order_relaxed) != before) continue;
+
+        if (slot_epoch != epoch) return 0;
+        out->valid = 1;
+        out->value_ms = value_nanos / 1e6;
+        out->time_nanos = time_nanos;
+        memcpy(out->trace_id, words, sizeof(words));
+        memcpy(out->span_id, &span_word, sizeof(span_word));
+        return 1;
+    }
+    return 0;
+}
+
+static void histogram_record(histogram_t *histogram, const double *bounds, double duration_ms,
+                             const uint8_t *trace_id, const uint8_t *span_id) {
+    size_t bucket = 0;
+    while (bucket < REQUEST_METRICS_BOUND_COUNT && duration_ms > bounds[bucket]) bucket++;
+
+    uint64_t nanos = duration_ms > 0 ? (uint64_t)(duration_ms * 1e6) : 0;
+    bump(&histogram->buckets[bucket], 1);
+    bump(&histogram->sum_nanos, nanos);
+    if (trace_id && span_id) offer_exemplar(&histogram->exemplar, nanos, trace_id, span_id);
+}
+
+static size_t table_index(shard_t *shard, const char *table_name) {
+    size_t count = atomic_load_explicit(&shard->table_count, memory_order_relaxed);
+    for (size_t i = 0; i < count; i++) {
+        if (strncmp(shard->names[i], table_name, REQUEST_METRICS_TABLE_NAME_SIZE - 1) == 0) return i;
+    }
+    if (count == REQUEST_METRICS_MAX_TABLES) return REQUEST_METRICS_MAX_TABLES;
+
+    /* Write the name before making it visible */
+    strncpy(shard->names[count], table_name, REQUEST_METRICS_TABLE_NAME_SIZE - 1);
+    shard->names[count][REQUEST_METRICS_TABLE_NAME_SIZE - 1] = '\0';
+    atomic_store_explicit(&shard->table_count, count + 1, memory_order_release);
+    return count;
+}
+
+void request_metrics_record(const char *table_name, request_status_t status, double duration_ms,
+                            const uint8_t *trace_id, const uint8_t *span_id) {
+    shard_t *shard = t_shard ? t_shard : register_shard();
+    if (!shard) return;
+    if (!table_name) table_name = "unknown";
+    if (status >= REQUEST_STATUS_COUNT) status = REQUEST_STATUS_ERROR;
+
+    histogram_record(&shard->tables[table_index(shard, table_name)][status],
+                     request_metrics_bounds, duration_ms, trace_id, span_id);
+}
+
+void request_metrics_record_stage(request_stage_t stage, double duration_ms,
+                                  const uint8_t *trace_id, const uint8_t *span_id) {
+    if (stage >= REQUEST_STAGE_COUNT) return;
+    shard_t *shard = t_shard ? t_shard : register_shard();
+    if (!shard) return;
+
+    histogram_record(&shard->stages[stage], request_metrics_stage_bounds, duration_ms,
+                     trace_id, span_id);
+}
+
+static int histogram_empty(histogram_t *histogram) {
+    for (size_t b = 0; b < REQUEST_METRICS_BUCKET_COUNT; b++) {
+        if (load_relaxed(&histogram->buckets[b]) != 0) return 0;
+    }
+    return 1;
+}
+
+/*
+ * Add one shard histogram into merged totals; returns 0 if it has no samples.
+ * The count is derived from the buckets so the two always agree.
+ */
+static int merge_histogram(histogram_t *histogram, uint64_t epoch, uint64_t *count, double *sum_ms,
+                           uint64_t *bucket_counts, request_metrics_exemplar_t *exemplar) {
+    uint64_t buckets[REQUEST_METRICS_BUCKET_COUNT];
+    uint64_t total = 0;
+    for (size_t b = 0; b < REQUEST_METRICS_BUCKET_COUNT; b++) {
+        buckets[b] = load_relaxed(&histogram->buckets[b]);
+        total += buckets[b];
+    }
+    if (total == 0) return 0;
+
+    *count += total;
+    *sum_ms += load_relaxed(&histogram->sum_nanos) / 1e6;
+    for (size_t b = 0; b < REQUEST_METRICS_BUCKET_COUNT; b++) bucket_counts[b] += buckets[b];
+
+    request_metrics_exemplar_t candidate;
+    if (read_exemplar(&histogram->exemplar, epoch, &candidate) &&
+        (!exemplar->valid || candidate.value_ms > exemplar->value_ms)) {
+        *exemplar = candidate;
+    }
+    return 1;
+}
+
+/* Find or add the merged series for (name, status); NULL when out is full */
+static request_metrics_series_t* merged_series(request_metrics_series_t *out, size_t *count,
+                                               size_t max, const char *name,
+                                               request_status_t status) {
+    for (size_t i = 0; i < *count; i++) {
+        if (out[i].status == status && strcmp(out[i].table_name, name) == 0) return &out[i];
+    }
+    if (*count == max) return NULL;
+
+    request_metrics_series_t *series = &out[(*count)++];
+    memset(series, 0, sizeof(*series));
+    strncpy(series->table_name, name, REQUEST_METRICS_TABLE_NAME_SIZE - 1);
+    series->status = status;
+    return series;
+}
+
+size_t request_metrics_collect(request_metrics_series_t *out, size_t max,
+                               request_metrics_stage_series_t *stages) {
+    size_t count = 0;
+    size_t shards = atomic_load_explicit(&g_shard_count, memory_order_relaxed);
+    if (shards > MAX_SHARDS) shards = MAX_SHARDS;
+
+    uint64_t epoch = atomic_load_explicit(&g_epoch, memory_order_relaxed);
+    memset(stages, 0, REQUEST_STAGE_COUNT * sizeof(*stages));
+
+    for (size_t s = 0; s < shards; s++) {
+        shard_t *shard = atomic_load_explicit(&g_shards[s], memory_order_acquire);
+        if (!shard) continue;   /* Still being set up */
+
+        size_t tables = atomic_load_explicit(&shard->table_count, memory_order_acquire);
+        for (size_t t = 0; t <= REQUEST_METRICS_MAX_TABLES; t++) {
+            if (t >= tables && t != REQUEST_METRICS_MAX_TABLES) continue;
+            const char *name = t < tables ? shard->names[t] : REQUEST_METRICS_OTHER_TABLE;
+
+            for (int status = 0; status < REQUEST_STATUS_COUNT; status++) {
+                histogram_t *histogram = &shard->tables[t][status];
+                if (histogram_empty(histogram)) continue;
+
+                request_metrics_series_t *series =
+                    merged_series(out, &count, max, name, (request_status_t)status);
+                if (!series) {
+                    series = merged_series(out, &count, max, REQUEST_METRICS_OTHER_TABLE,
+                                           (request_status_t)status);
+                    if (!series) continue;
+                }
+                merge_histogram(histogram, epoch, &series->count, &series->sum_ms,
+                                series->bucket_counts, &series->exemplar);
+            }
+        }
+
+        for (int stage = 0; stage < REQUEST_STAGE_COUNT; stage++) {
+            request_metrics_stage_series_t *series = &stages[stage];
+            merge_histogram(&shard->stages[stage], epoch, &series->count, &series->sum_ms,
+                            series->bucket_counts, &series->exemplar);
+        }
+    }
+
+    /* Exemplars recorded from now on belong to the next export */
+    atomic_store_explicit(&g_epoch, epoch + 1, memory_order_relaxed);
+    return count;
+}
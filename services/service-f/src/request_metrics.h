@@ -0,0 +1,132 @@
+/*
+ * Request metrics without a shared lock
+ *
+ * Every recording thread owns a cache-line aligned shard of counters and
+ * fixed-bucket latency histograms, one per (table_name, status) series.
+ * A shard has a single writer, so recording is plain relaxed atomic loads
+ * and stores: no lock and no contended read-modify-write. The export
+ * thread sums all shards into cumulative series.
+ *
+ * Each shard tracks up to REQUEST_METRICS_MAX_TABLES table names. Further
+ * names are folded into the REQUEST_METRICS_OTHER_TABLE series.
+ *
+ * Alongside the per-table totals, every request's time is split into
+ * stages with their own histograms. Each histogram keeps the slowest
+ * sampled request of the current export interval as an exemplar, so a
+ * latency spike links straight to a trace.
+ */
+
+#ifndef REQUEST_METRICS_H
+#define REQUEST_METRICS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "trace_context.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define REQUEST_METRICS_MAX_TABLES 32
+#define REQUEST_METRICS_TABLE_NAME_SIZE 64
+#define REQUEST_METRICS_OTHER_TABLE "_other"
+
+/* Explicit histogram bounds in milliseconds; buckets = bounds + 1 */
+#define REQUEST_METRICS_BOUND_COUNT 13
+#define REQUEST_METRICS_BUCKET_COUNT (REQUEST_METRICS_BOUND_COUNT + 1)
+extern const double request_metrics_bounds[REQUEST_METRICS_BOUND_COUNT];
+/* Finer bounds for stage histograms, same bucket count */
+extern const double request_metrics_stage_bounds[REQUEST_METRICS_BOUND_COUNT];
+
+typedef enum {
+    REQUEST_STATUS_OK = 0,
+    REQUEST_STATUS_ERROR = 1,
+    REQUEST_STATUS_COUNT
+} request_status_t;
+
+/* Label for a status ("ok" / "error") */
+const char* request_status_name(request_status_t status);
+
+/* Consecutive parts of a FetchLegacyData call */
+typedef enum {
+    REQUEST_STAGE_PARSE = 0,    /* Trace context extraction and request unpacking */
+    REQUEST_STAGE_DB,           /* Simulated DB lookup, including timer lateness */
+    REQUEST_STAGE_RESPOND,      /* Building and packing the response */
+    REQUEST_STAGE_SEND,         /* Send batch until its completion */
+    REQUEST_STAGE_TELEMETRY,    /* Our own logs, spans and metrics */
+    REQUEST_STAGE_COUNT
+} request_stage_t;
+
+/* Label for a stage ("parse", "db", ...) */
+const char* request_stage_name(request_stage_t stage);
+
+/* Slowest sampled request of an export interval */
+typedef struct {
+    int valid;
+    double value_ms;
+    uint64_t time_nanos;        /* Wall clock time it was recorded */
+    uint8_t trace_id[OTLP_TRACE_ID_SIZE];
+    uint8_t span_id[OTLP_SPAN_ID_SIZE];
+} request_metrics_exemplar_t;
+
+/* One merged series as seen by the exporter */
+typedef struct {
+    char table_name[REQUEST_METRICS_TABLE_NAME_SIZE];
+    request_status_t status;
+    uint64_t count;
+    double sum_ms;
+    uint64_t bucket_counts[REQUEST_METRICS_BUCKET_COUNT];
+    request_metrics_exemplar_t exemplar;
+} request_metrics_series_t;
+
+/* One merged stage histogram */
+typedef struct {
+    uint64_t count;
+    double sum_ms;
+    uint64_t bucket_counts[REQUEST_METRICS_BUCKET_COUNT];
+    request_metrics_exemplar_t exemplar;
+} request_metrics_stage_series_t;
+
+/*
+ * Record one finished request on the calling thread's shard
+ *
+ * @param table_name   Table label; truncated to fit, NULL is recorded as "unknown"
+ * @param status       Outcome of the request
+ * @param duration_ms  Request latency
+ * @param trace_id     Exemplar trace (OTLP_TRACE_ID_SIZE bytes), or NULL if not sampled
+ * @param span_id      Exemplar span (OTLP_SPAN_ID_SIZE bytes), or NULL if not sampled
+ */
+void request_metrics_record(const char *table_name, request_status_t status, double duration_ms,
+                            const uint8_t *trace_id, const uint8_t *span_id);
+
+/*
+ * Record the time one request spent in a stage
+ *
+ * @param stage        Stage the time belongs to
+ * @param duration_ms  Time spent in the stage
+ * @param trace_id     Exemplar trace, or NULL if not sampled
+ * @param span_id      Exemplar span, or NULL if not sampled
+ */
+void request_metrics_record_stage(request_stage_t stage, double duration_ms,
+                                  const uint8_t *trace_id, const uint8_t *span_id);
+
+/*
+ * Sum every shard into cumulative series (safe to call from one thread at a time)
+ *
+ * Exemplars are taken from the interval since the previous collection,
+ * which starts a new interval.
+ *
+ * @param out     Receives up to max series; series with no requests are skipped
+ * @param max     Capacity of out
+ * @param stages  Receives REQUEST_STAGE_COUNT stage histograms, indexed by stage
+ * @return  Number of series written
+ */
+size_t request_metrics_collect(request_metrics_series_t *out, size_t max,
+                               request_metrics_stage_series_t *stages);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* REQUEST_METRICS_H */
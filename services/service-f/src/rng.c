@@ -0,0 +1,95 @@
+/*
+ * Per-thread pseudo-random number generator
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE
+
+#include "rng.h"
+
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/random.h>
+
+typedef struct {
+    uint64_t s[4];
+    int seeded;
+} rng_state_t;
+
+static _Thread_local rng_state_t t_rng;
+
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static void rng_seed(rng_state_t *rng) {
+    uint64_t seed;
+    if (getrandom(&seed, sizeof(seed), GRND_NONBLOCK) != (ssize_t)sizeof(seed)) {
+        /* Entropy pool not ready yet: mix the clock with this thread's identity */
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        seed = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+        seed ^= (uint64_t)(uintptr_t)&t_rng ^ (uint64_t)pthread_self();
+    }
+
+    /* splitmix64 expands the seed so the xoshiro state is never all zero */
+    for (int i = 0; i < 4; i++) {
+        rng->s[i] = splitmix64(&seed);
+    }
+    rng->seeded = 1;
+}
+
+uint64_t rng_next_u64(void) {
+    rng_state_t *rng = &t_rng;
+    if (!rng->seeded) rng_seed(rng);
+
+    uint64_t *s = rng->s;
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+
+    return result;
+}
+
+uint32_t rng_uniform(uint32_t bound) {
+    if (bound == 0) return 0;
+
+    /* Lemire's multiply-shift with rejection of the biased low range */
+    uint64_t m = (rng_next_u64() >> 32) * bound;
+    uint32_t low = (uint32_t)m;
+    if (low < bound) {
+        uint32_t threshold = -bound % bound;
+        while (low < threshold) {
+            m = (rng_next_u64() >> 32) * bound;
+            low = (uint32_t)m;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+void rng_fill(uint8_t *out, size_t len) {
+    while (len >= sizeof(uint64_t)) {
+        uint64_t r = rng_next_u64();
+        memcpy(out, &r, sizeof(r));
+        out += sizeof(r);
+        len -= sizeof(r);
+    }
+    if (len > 0) {
+        uint64_t r = rng_next_u64();
+        memcpy(out, &r, len);
+    }
+}
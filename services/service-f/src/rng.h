@@ -0,0 +1,49 @@
+/*
+ * Per-thread pseudo-random number generator
+ *
+ * xoshiro256** with one state per thread, seeded from getrandom() and
+ * expanded with splitmix64. Nothing is shared between threads, so request
+ * workers never contend on a lock the way they do on libc's rand().
+ * Not suitable for cryptographic use.
+ */
+
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Next 64 random bits from the calling thread's generator
+ *
+ * The generator is seeded lazily on first use in each thread.
+ *
+ * @return  Uniformly distributed 64-bit value
+ */
+uint64_t rng_next_u64(void);
+
+/*
+ * Uniform integer in [0, bound) without modulo bias
+ *
+ * @param bound  Exclusive upper bound (0 returns 0)
+ * @return  Random value below bound
+ */
+uint32_t rng_uniform(uint32_t bound);
+
+/*
+ * Fill a buffer with random bytes (8 bytes per generator step)
+ *
+ * @param out  Output buffer
+ * @param len  Number of bytes
+ */
+void rng_fill(uint8_t *out, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RNG_H */
@@ -0,0 +1,281 @@
+/*
+ * Error-biased tail sampling for finished spans
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE
+
+#include "tail_sampler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace_context.h"
+
+#define DEFAULT_KEEP_RATIO 1.0
+#define DEFAULT_LATENCY_PERCENTILE 99.0
+#define DEFAULT_WINDOW_MILLIS 2000
+#define DEFAULT_MAX_SPANS 8192
+
+/* Root durations the latency percentile is computed over */
+#define LATENCY_SAMPLES 1024
+/* Roots needed before the percentile is trusted, and between recomputations */
+#define LATENCY_MIN_SAMPLES 128
+#define LATENCY_UPDATE_INTERVAL 64
+
+#define NONE (-1)
+
+/* Spans of one trace waiting for a decision */
+typedef struct {
+    uint8_t trace_id[OTLP_TRACE_ID_SIZE];
+    uint64_t first_nanos;   /* Arrival of the first span */
+    int32_t head, tail;     /* Item list, in arrival order */
+    int32_t bucket_next;    /* Hash chain */
+    int32_t older, newer;   /* Age list */
+    uint8_t has_error;
+} trace_entry_t;
+
+struct tail_sampler {
+    tail_sampler_options_t options;
+    uint64_t window_nanos;
+    tail_sampler_emit_fn emit;
+    void *ctx;
+
+    /* Item pool; item_next links both trace item lists and the free list */
+    size_t item_size;
+    uint8_t *items;
+    int32_t *item_next;
+    int32_t free_items;
+
+    /* Trace pool, hashed by trace ID and listed by age */
+    trace_entry_t *traces;
+    int32_t free_traces;
+    int32_t *buckets;
+    size_t bucket_mask;
+    int32_t oldest, newest;
+
+    /* Ring of recent root durations and the percentile derived from it */
+    uint64_t latencies[LATENCY_SAMPLES];
+    uint64_t scratch[LATENCY_SAMPLES];
+    size_t latency_count;
+    size_t latency_pos;
+    size_t since_update;
+    uint64_t latency_threshold;     /* 0 until enough roots were seen */
+};
+
+/* Parse <prefix>_<name> as a non-negative number */
+static double env_double(const char *prefix, const char *name, double default_value) {
+    char key[64];
+    snprintf(key, sizeof(key), "%s_%s", prefix, name);
+
+    const char *value = getenv(key);
+    if (!value || !*value) return default_value;
+
+    char *end;
+    double parsed = strtod(value, &end);
+    if (*end != '\0' || parsed < 0.0) {
+        fprintf(stderr, "[OTLP] Ignoring invalid %s=%s\n", key, value);
+        return default_value;
+    }
+    return parsed;
+}
+
+void tail_sampler_options_from_env(tail_sampler_options_t *options, const char *prefix) {
+    options->keep_ratio = env_double(prefix, "RATIO", DEFAULT_KEEP_RATIO);
+    options->latency_percentile = env_double(prefix, "PERCENTILE", DEFAULT_LATENCY_PERCENTILE);
+    options->window_millis = (uint32_t)env_double(prefix, "WINDOW_MS", DEFAULT_WINDOW_MILLIS);
+    options->max_spans = (size_t)env_double(prefix, "MAX_SPANS", DEFAULT_MAX_SPANS);
+
+    if (options->keep_ratio > 1.0) options->keep_ratio = 1.0;
+    if (options->latency_percentile >= 100.0) options->latency_percentile = 0.0;
+    if (options->max_spans == 0) options->max_spans = DEFAULT_MAX_SPANS;
+}
+
+static size_t bucket_of(const tail_sampler_t *sampler, const uint8_t *trace_id) {
+    /* Trace IDs are random; the low bytes are a good enough hash */
+    uint64_t h;
+    memcpy(&h, trace_id + OTLP_TRACE_ID_SIZE - 8, sizeof(h));
+    return (size_t)(h * 0x9E3779B97F4A7C15ULL >> 17) & sampler->bucket_mask;
+}
+
+static int32_t find_trace(const tail_sampler_t *sampler, const uint8_t *trace_id) {
+    int32_t t = sampler->buckets[bucket_of(sampler, trace_id)];
+    while (t != NONE && memcmp(sampler->traces[t].trace_id, trace_id, OTLP_TRACE_ID_SIZE) != 0) {
+        t = sampler->traces[t].bucket_next;
+    }
+    return t;
+}
+
+/* Emit or drop a trace's spans, then return it and its items to the pools */
+static void decide(tail_sampler_t *sampler, int32_t t, int keep) {
+    trace_entry_t *trace = &sampler->traces[t];
+
+    int32_t item = trace->head;
+    while (item != NONE) {
+        int32_t next = sampler->item_next[item];
+        if (keep) sampler->emit(sampler->ctx, sampler->items + (size_t)item * sampler->item_size);
+        sampler->item_next[item] = sampler->free_items;
+        sampler->free_items = item;
+        item = next;
+    }
+
+    /* Unhash */
+    int32_t *link = &sampler->buckets[bucket_of(sampler, trace->trace_id)];
+    while (*link != t) link = &sampler->traces[*link].bucket_next;
+    *link = trace->bucket_next;
+
+    /* Unlink from the age list */
+    if (trace->older != NONE) sampler->traces[trace->older].newer = trace->newer;
+    else sampler->oldest = trace->newer;
+    if (trace->newer != NONE) sampler->traces[trace->newer].older = trace->older;
+    else sampler->newest = trace->older;
+
+    trace->bucket_next = sampler->free_traces;
+    sampler->free_traces = t;
+}
+
+/* Keep decision for a trace without a (timely) root span */
+static int keep_orphan(const tail_sampler_t *sampler, const trace_entry_t *trace) {
+    return trace->has_error || trace_id_ratio_sampled(trace->trace_id, sampler->options.keep_ratio);
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static void record_latency(tail_sampler_t *sampler, uint64_t duration_nanos) {
+    if (sampler->options.latency_percentile <= 0.0) return;
+
+    sampler->latencies[sampler->latency_pos] = duration_nanos;
+    sampler->latency_pos = (sampler->latency_pos + 1) % LATENCY_SAMPLES;
+    if (sampler->latency_count < LATENCY_SAMPLES) sampler->latency_count++;
+
+    if (sampler->latency_count < LATENCY_MIN_SAMPLES) return;
+    if (++sampler->since_update < LATENCY_UPDATE_INTERVAL && sampler->latency_threshold != 0) return;
+    sampler->since_update = 0;
+
+    size_t n = sampler->latency_count;
+    memcpy(sampler->scratch, sampler->latencies, n * sizeof(uint64_t));
+    qsort(sampler->scratch, n, sizeof(uint64_t), compare_u64);
+    size_t k = (size_t)(sampler->options.latency_percentile / 100.0 * (double)(n - 1));
+    sampler->latency_threshold = sampler->scratch[k];
+}
+
+tail_sampler_t* tail_sampler_create(const tail_sampler_options_t *options, size_t item_size,
+                                    tail_sampler_emit_fn emit, void *ctx) {
+    if (!options || item_size == 0 || !emit || options->max_spans == 0) return NULL;
+
+    tail_sampler_t *sampler = calloc(1, sizeof(tail_sampler_t));
+    if (!sampler) return NULL;
+
+    size_t capacity = options->max_spans;
+    size_t buckets = 1;
+    while (buckets < capacity * 2) buckets <<= 1;
+
+    sampler->options = *options;
+    sampler->window_nanos = (uint64_t)options->window_millis * 1000000ULL;
+    sampler->emit = emit;
+    sampler->ctx = ctx;
+    sampler->item_size = item_size;
+    sampler->items = malloc(capacity * item_size);
+    sampler->item_next = malloc(capacity * sizeof(int32_t));
+    sampler->traces = malloc(capacity * sizeof(trace_entry_t));
+    sampler->buckets = malloc(buckets * sizeof(int32_t));
+    sampler->bucket_mask = buckets - 1;
+
+    if (!sampler->items || !sampler->item_next || !sampler->traces || !sampler->buckets) {
+        tail_sampler_destroy(sampler);
+        return NULL;
+    }
+
+    /* Both pools start out fully on their free lists */
+    for (size_t i = 0; i < capacity; i++) {
+        sampler->item_next[i] = i + 1 < capacity ? (int32_t)(i + 1) : NONE;
+        sampler->traces[i].bucket_next = i + 1 < capacity ? (int32_t)(i + 1) : NONE;
+    }
+    sampler->free_items = 0;
+    sampler->free_traces = 0;
+    for (size_t i = 0; i < buckets; i++) sampler->buckets[i] = NONE;
+    sampler->oldest = sampler->newest = NONE;
+
+    return sampler;
+}
+
+void tail_sampler_add(tail_sampler_t *sampler, const void *item, const uint8_t *trace_id,
+                      int is_root, int is_error, uint64_t duration_nanos, uint64_t now_nanos) {
+    /*
+     * Out of room: settle the oldest trace early rather than drop this span.
+     * Every buffered trace holds at least one item, so a free item implies
+     * a free trace entry.
+     */
+    if (sampler->free_items == NONE) {
+        decide(sampler, sampler->oldest, keep_orphan(sampler, &sampler->traces[sampler->oldest]));
+    }
+
+    int32_t t = find_trace(sampler, trace_id);
+    if (t == NONE) {
+        t = sampler->free_traces;
+        trace_entry_t *trace = &sampler->traces[t];
+        sampler->free_traces = trace->bucket_next;
+
+        memcpy(trace->trace_id, trace_id, OTLP_TRACE_ID_SIZE);
+        trace->first_nanos = now_nanos;
+        trace->head = trace->tail = NONE;
+        trace->has_error = 0;
+
+        size_t bucket = bucket_of(sampler, trace_id);
+        trace->bucket_next = sampler->buckets[bucket];
+        sampler->buckets[bucket] = t;
+
+        trace->older = sampler->newest;
+        trace->newer = NONE;
+        if (sampler->newest != NONE) sampler->traces[sampler->newest].newer = t;
+        else sampler->oldest = t;
+        sampler->newest = t;
+    }
+
+    trace_entry_t *trace = &sampler->traces[t];
+
+    int32_t slot = sampler->free_items;
+    sampler->free_items = sampler->item_next[slot];
+    memcpy(sampler->items + (size_t)slot * sampler->item_size, item, sampler->item_size);
+    sampler->item_next[slot] = NONE;
+    if (trace->tail != NONE) sampler->item_next[trace->tail] = slot;
+    else trace->head = slot;
+    trace->tail = slot;
+
+    if (is_error) trace->has_error = 1;
+    if (!is_root) return;
+
+    /* Compare with the roots seen so far, then add this one */
+    int slow = sampler->latency_threshold != 0 && duration_nanos > sampler->latency_threshold;
+    record_latency(sampler, duration_nanos);
+
+    decide(sampler, t, trace->has_error || slow ||
+                       trace_id_ratio_sampled(trace->trace_id, sampler->options.keep_ratio));
+}
+
+void tail_sampler_expire(tail_sampler_t *sampler, uint64_t now_nanos) {
+    while (sampler->oldest != NONE) {
+        trace_entry_t *trace = &sampler->traces[sampler->oldest];
+        if (now_nanos - trace->first_nanos < sampler->window_nanos) break;
+        decide(sampler, sampler->oldest, keep_orphan(sampler, trace));
+    }
+}
+
+void tail_sampler_drain(tail_sampler_t *sampler) {
+    while (sampler->oldest != NONE) {
+        decide(sampler, sampler->oldest, keep_orphan(sampler, &sampler->traces[sampler->oldest]));
+    }
+}
+
+void tail_sampler_destroy(tail_sampler_t *sampler) {
+    if (!sampler) return;
+    free(sampler->items);
+    free(sampler->item_next);
+    free(sampler->traces);
+    free(sampler->buckets);
+    free(sampler);
+}
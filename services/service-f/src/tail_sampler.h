@@ -0,0 +1,99 @@
+/*
+ * Error-biased tail sampling for finished spans
+ *
+ * Spans are held per trace_id until the trace's local root span finishes
+ * (or the trace has waited out the window). Then the whole trace is
+ * either emitted or dropped. A trace is always kept if any of its spans
+ * has error status, or if its root took longer than the configured
+ * percentile of recent roots. Every other trace is kept at the base
+ * ratio, which uses the same trace-ID rule as trace_id_ratio_sampled().
+ *
+ * A sampler is not thread-safe. The exporter drives it from the pipeline
+ * thread only. Items are opaque fixed-size records copied into a
+ * preallocated pool, so nothing is allocated after creation.
+ */
+
+#ifndef TAIL_SAMPLER_H
+#define TAIL_SAMPLER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    double keep_ratio;          /* Share of ordinary traces kept; 1.0 disables tail sampling */
+    double latency_percentile;  /* Roots slower than this percentile are kept; 0 disables */
+    uint32_t window_millis;     /* Longest a trace waits for its root span */
+    size_t max_spans;           /* Spans held at once; the oldest traces are decided early beyond it */
+} tail_sampler_options_t;
+
+/* Called once for every span of a kept trace */
+typedef void (*tail_sampler_emit_fn)(void *ctx, const void *item);
+
+typedef struct tail_sampler tail_sampler_t;
+
+/*
+ * Fill options with defaults, then apply <prefix>_RATIO, <prefix>_PERCENTILE,
+ * <prefix>_WINDOW_MS and <prefix>_MAX_SPANS from the environment
+ *
+ * @param options  Options to fill
+ * @param prefix   Environment variable prefix, e.g. "SERVICE_F_TRACE_TAIL"
+ */
+void tail_sampler_options_from_env(tail_sampler_options_t *options, const char *prefix);
+
+/*
+ * Create a sampler
+ *
+ * @param options    Sampling options
+ * @param item_size  Size of one buffered item in bytes
+ * @param emit       Receives the items of kept traces, in arrival order
+ * @param ctx        Passed to emit
+ * @return  Sampler, or NULL on allocation failure
+ */
+tail_sampler_t* tail_sampler_create(const tail_sampler_options_t *options, size_t item_size,
+                                    tail_sampler_emit_fn emit, void *ctx);
+
+/*
+ * Buffer one finished span
+ *
+ * @param sampler         Sampler
+ * @param item            item_size bytes to copy
+ * @param trace_id        OTLP_TRACE_ID_SIZE bytes
+ * @param is_root         Nonzero for the trace's local root; decides the trace
+ * @param is_error        Nonzero if the span has error status
+ * @param duration_nanos  Span duration, used for the latency percentile of roots
+ * @param now_nanos       CLOCK_MONOTONIC time of the call
+ */
+void tail_sampler_add(tail_sampler_t *sampler, const void *item, const uint8_t *trace_id,
+                      int is_root, int is_error, uint64_t duration_nanos, uint64_t now_nanos);
+
+/*
+ * Decide traces that have waited longer than the window
+ *
+ * @param sampler    Sampler
+ * @param now_nanos  CLOCK_MONOTONIC time
+ */
+void tail_sampler_expire(tail_sampler_t *sampler, uint64_t now_nanos);
+
+/*
+ * Decide every buffered trace now (used on shutdown)
+ *
+ * @param sampler  Sampler
+ */
+void tail_sampler_drain(tail_sampler_t *sampler);
+
+/*
+ * Destroy a sampler; buffered spans are discarded
+ *
+ * @param sampler  Sampler
+ */
+void tail_sampler_destroy(tail_sampler_t *sampler);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TAIL_SAMPLER_H */
@@ -0,0 +1,94 @@
+/*
+ * Trace context helpers
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE
+
+#include "trace_context.h"
+
+/* Layout of "00-<32 hex>-<16 hex>-<2 hex>" */
+#define TRACEPARENT_LENGTH 55
+#define TRACEPARENT_TRACE_ID_OFFSET 3
+#define TRACEPARENT_SPAN_ID_OFFSET 36
+#define TRACEPARENT_FLAGS_OFFSET 53
+
+static const char hex_digits[16] = {
+    '0', '1', '2', '3', '4', '5', '6', '7',
+    '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'
+};
+
+/* Digit value plus one, so every unlisted character maps to 0 (invalid) */
+static const uint8_t hex_values[256] = {
+    ['0'] = 1,  ['1'] = 2,  ['2'] = 3,  ['3'] = 4,  ['4'] = 5,
+    ['5'] = 6,  ['6'] = 7,  ['7'] = 8,  ['8'] = 9,  ['9'] = 10,
+    ['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+    ['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16,
+};
+
+void hex_encode(const uint8_t *bytes, size_t len, char *out) {
+    for (size_t i = 0; i < len; i++) {
+        out[2 * i] = hex_digits[bytes[i] >> 4];
+        out[2 * i + 1] = hex_digits[bytes[i] & 0x0f];
+    }
+    out[2 * len] = '\0';
+}
+
+int hex_decode(const char *hex, uint8_t *bytes, size_t len) {
+    /* Accumulate a validity mask instead of branching on every digit */
+    uint8_t invalid = 0;
+    for (size_t i = 0; i < len; i++) {
+        uint8_t hi = hex_values[(unsigned char)hex[2 * i]];
+        uint8_t lo = hex_values[(unsigned char)hex[2 * i + 1]];
+        invalid |= (uint8_t)((hi == 0) | (lo == 0));
+        bytes[i] = (uint8_t)(((hi - 1) << 4) | ((lo - 1) & 0x0f));
+    }
+    return invalid ? -1 : 0;
+}
+
+int trace_id_is_valid(const uint8_t *id, size_t len) {
+    uint8_t any = 0;
+    for (size_t i = 0; i < len; i++) any |= id[i];
+    return any != 0;
+}
+
+int trace_id_ratio_sampled(const uint8_t *trace_id, double ratio) {
+    if (ratio >= 1.0) return 1;
+    if (ratio <= 0.0) return 0;
+
+    uint64_t value = 0;
+    for (size_t i = OTLP_TRACE_ID_SIZE - 8; i < OTLP_TRACE_ID_SIZE; i++) {
+        value = (value << 8) | trace_id[i];
+    }
+    /* Top 53 bits, exactly representable as a double */
+    return (double)(value >> 11) < ratio * 9007199254740992.0;
+}
+
+int trace_context_parse_traceparent(const char *value, size_t len,
+                                    uint8_t *trace_id, uint8_t *parent_span_id,
+                                    uint8_t *trace_flags) {
+    if (len < TRACEPARENT_LENGTH) return -1;
+    if (value[2] != '-' || value[TRACEPARENT_SPAN_ID_OFFSET - 1] != '-' ||
+        value[TRACEPARENT_FLAGS_OFFSET - 1] != '-') {
+        return -1;
+    }
+
+    /* Version ff is reserved as invalid */
+    uint8_t version;
+    if (hex_decode(value, &version, 1) != 0 || version == 0xff) return -1;
+
+    if (hex_decode(value + TRACEPARENT_TRACE_ID_OFFSET, trace_id, OTLP_TRACE_ID_SIZE) != 0 ||
+        hex_decode(value + TRACEPARENT_SPAN_ID_OFFSET, parent_span_id, OTLP_SPAN_ID_SIZE) != 0) {
+        return -1;
+    }
+
+    if (!trace_id_is_valid(trace_id, OTLP_TRACE_ID_SIZE) ||
+        !trace_id_is_valid(parent_span_id, OTLP_SPAN_ID_SIZE)) {
+        return -1;
+    }
+
+    uint8_t flags;
+    if (hex_decode(value + TRACEPARENT_FLAGS_OFFSET, &flags, 1) != 0) return -1;
+    if (trace_flags) *trace_flags = flags;
+    return 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * Trace context helpers
+ *
+ * Trace and span IDs travel through the service as raw 16- and 8-byte
+ * arrays, exactly as OTLP encodes them. Hex text only appears at the edges:
+ * parsing the W3C traceparent header and printing IDs to stdout.
+ */
+
+#ifndef TRACE_CONTEXT_H
+#define TRACE_CONTEXT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OTLP_TRACE_ID_SIZE 16
+#define OTLP_SPAN_ID_SIZE 8
+
+/* W3C trace-flags bit: the caller recorded this trace */
+#define TRACE_FLAG_SAMPLED 0x01
+
+/* Hex buffer sizes including the terminating NUL */
+#define OTLP_TRACE_ID_HEX_SIZE (OTLP_TRACE_ID_SIZE * 2 + 1)
+#define OTLP_SPAN_ID_HEX_SIZE (OTLP_SPAN_ID_SIZE * 2 + 1)
+
+/*
+ * Encode bytes as lowercase hex
+ *
+ * @param bytes  Input bytes
+ * @param len    Number of input bytes
+ * @param out    Output buffer of at least 2 * len + 1 chars (NUL-terminated)
+ */
+void hex_encode(const uint8_t *bytes, size_t len, char *out);
+
+/*
+ * Decode exactly 2 * len hex digits (either case)
+ *
+ * @param hex    Input text; need not be NUL-terminated
+ * @param bytes  Output buffer of len bytes
+ * @param len    Number of bytes to produce
+ * @return  0 on success, -1 if a non-hex character was found
+ */
+int hex_decode(const char *hex, uint8_t *bytes, size_t len);
+
+/*
+ * Check that an ID is not all zeroes (the W3C/OTLP "invalid" value)
+ *
+ * @param id   ID bytes
+ * @param len  ID length
+ * @return  1 if valid, 0 otherwise
+ */
+int trace_id_is_valid(const uint8_t *id, size_t len);
+
+/*
+ * Deterministic ratio sampling on the trace ID
+ *
+ * Compares the low 8 bytes of the ID with the ratio. service-e's tail
+ * sampler (TraceIdRatioSampled) uses the same rule, so the two tail samplers
+ * keep the same ordinary traces at the same ratio. service-e's head sampler
+ * is the OpenTelemetry SDK's, which reads other bytes, so head decisions
+ * only line up through the parent's sampled flag.
+ *
+ * @param trace_id  OTLP_TRACE_ID_SIZE bytes
+ * @param ratio     Share of traces to sample, 0.0 - 1.0
+ * @return  1 if the trace falls inside the ratio, 0 otherwise
+ */
+int trace_id_ratio_sampled(const uint8_t *trace_id, double ratio);
+
+/*
+ * Parse a W3C traceparent header value (version-traceid-spanid-flags)
+ *
+ * @param value           Header value; need not be NUL-terminated
+ * @param len             Length of value
+ * @param trace_id        Receives OTLP_TRACE_ID_SIZE bytes
+ * @param parent_span_id  Receives OTLP_SPAN_ID_SIZE bytes
+ * @param trace_flags     Receives the trace-flags byte (may be NULL)
+ * @return  0 on success, -1 if the header is malformed or carries invalid IDs
+ */
+int trace_context_parse_traceparent(const char *value, size_t len,
+                                    uint8_t *trace_id, uint8_t *parent_span_id,
+                                    uint8_t *trace_flags);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRACE_CONTEXT_H */
@@ -0,0 +1,139 @@
+"""Build a legacy store snapshot (.lrs) for service-f's FetchLegacyData.
+
+Records come from a JSON Lines file with one object per line:
+    {"id": "record-1", "raw_data": "...", "created_at": 1700000000, "updated_at": 1700000000}
+
+or are generated to match the IDs tools/loadgen/loadgen.py asks for:
+    python tools/legacy_store/build_snapshot.py --synthetic 100000 --table legacy_records data/
+
+The snapshot is written to a temporary file and renamed into place, so a
+running service-f picks it up on its next rescan without ever seeing a
+partial file. See services/service-f/src/legacy_store.h for the layout.
+"""
+
+import argparse
+import json
+import os
+import struct
+import sys
+import tempfile
+import time
+
+MAGIC = b"LRSTORE1"
+VERSION = 1
+HEADER = struct.Struct("<8sIIQQQQQQ")
+SLOT = struct.Struct("<QQ")
+RECORD = struct.Struct("<IIqq")
+
+
+def record_hash(record_id):
+    """64-bit FNV-1a; 0 is reserved for empty slots."""
+    h = 0xCBF29CE484222325
+    for byte in record_id:
+        h ^= byte
+        h = (h * 0x100000001B3) & 0xFFFFFFFFFFFFFFFF
+    return h or 1
+
+
+def align8(n):
+    return (n + 7) & ~7
+
+
+def read_jsonl(path):
+    with open(path, encoding="utf-8") as f:
+        for line_no, line in enumerate(f, 1):
+            line = line.strip()
+            if not line:
+                continue
+            obj = json.loads(line)
+            if "id" not in obj:
+                sys.exit(f"{path}:{line_no}: missing id")
+            raw = obj.get("raw_data", "")
+            if not isinstance(raw, str):
+                raw = json.dumps(raw, separators=(",", ":"))
+            yield (str(obj["id"]).encode(), raw.encode(),
+                   int(obj.get("created_at", 0)), int(obj.get("updated_at", 0)))
+
+
+def synthetic(count, table):
+    now = int(time.time())
+    for i in range(count):
+        record_id = f"record-{i}"
+        raw = json.dumps({"source": table, "data": f"legacy_value_{record_id}"})
+        yield record_id.encode(), raw.encode(), now - 86400, now
+
+
+def build(records, out_path):
+    records = list(records)
+    slot_count = 1
+    while slot_count < 2 * max(len(records), 1):   # Load factor <= 0.5
+        slot_count *= 2
+
+    index_offset = align8(HEADER.size)
+    data_offset = index_offset + slot_count * SLOT.size
+
+    slots = [(0, 0)] * slot_count
+    data = bytearray()
+    seen = set()
+    order = []
+    for record_id, raw, created_at, updated_at in records:
+        if record_id in seen:
+            sys.exit(f"duplicate record id {record_id.decode(errors='replace')}")
+        seen.add(record_id)
+
+        h = record_hash(record_id)
+        slot = h & (slot_count - 1)
+        while slots[slot][0] != 0:
+            slot = (slot + 1) & (slot_count - 1)
+        slots[slot] = (h, data_offset + len(data))
+        order.append((record_id, data_offset + len(data)))
+
+        data += RECORD.pack(len(record_id), len(raw), created_at, updated_at)
+        data += record_id + raw
+        data += b"\0" * (align8(len(data)) - len(data))
+
+    # Offsets in ID order, for StreamLegacyData range scans
+    order.sort()
+    order_offset = data_offset + len(data)
+    file_size = order_offset + len(order) * 8
+    out_dir = os.path.dirname(os.path.abspath(out_path))
+    fd, tmp_path = tempfile.mkstemp(dir=out_dir, suffix=".tmp")
+    try:
+        with os.fdopen(fd, "wb") as f:
+            f.write(HEADER.pack(MAGIC, VERSION, 0, len(records), slot_count,
+                                index_offset, data_offset, file_size, order_offset))
+            f.write(b"\0" * (index_offset - HEADER.size))
+            for h, offset in slots:
+                f.write(SLOT.pack(h, offset))
+            f.write(data)
+            for _, offset in order:
+                f.write(struct.pack("<Q", offset))
+        os.chmod(tmp_path, 0o644)
+        os.replace(tmp_path, out_path)
+    except BaseException:
+        os.unlink(tmp_path)
+        raise
+    return len(records), file_size
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("out_dir", help="Store directory (SERVICE_F_LEGACY_STORE_DIR)")
+    parser.add_argument("--table", required=True, help="Table name; written as <table>.lrs")
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--input", help="JSON Lines file of records")
+    source.add_argument("--synthetic", type=int, metavar="N",
+                        help="Generate record-0 .. record-N-1")
+    args = parser.parse_args()
+
+    if "/" in args.table or args.table.startswith("."):
+        sys.exit("--table must be a plain file name")
+
+    records = read_jsonl(args.input) if args.input else synthetic(args.synthetic, args.table)
+    out_path = os.path.join(args.out_dir, args.table + ".lrs")
+    count, size = build(records, out_path)
+    print(f"Wrote {out_path}: {count} records, {size} bytes")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,253 @@
+"""Open-loop load generator for ServiceE.Compute and ServiceF.FetchLegacyData.
+
+Requests are sent on a fixed schedule regardless of how fast the server
+answers, and each latency is measured from the request's scheduled send
+time, so a stalled server shows up in the tail instead of silently slowing
+the generator down (coordinated omission).
+
+Fixed rate:
+    python tools/loadgen/loadgen.py --service e --rps 500 --duration 30
+
+Ramp to the maximum sustainable throughput, stepping the rate until the
+p99 exceeds --slo-ms or the error rate exceeds --max-error-rate:
+    python tools/loadgen/loadgen.py --service f --ramp 100:5000:100
+
+Only failed RPCs and requests skipped at --max-in-flight count as errors.
+Calls that succeed with status.success false (e.g. ServiceE's simulated
+ServiceD validation failures) are reported separately as "unsuccessful".
+
+Service f can also be driven through its bulk RPCs, fetching --batch-size
+records per call:
+    python tools/loadgen/loadgen.py --service f --rpc batch --batch-size 100
+"""
+
+import argparse
+import asyncio
+import os
+import random
+import sys
+import tempfile
+import time
+import uuid
+
+import grpc
+from grpc import aio
+from grpc_tools import protoc
+
+REPO_ROOT = os.path.abspath(os.path.join(os.path.dirname(__file__), "..", ".."))
+
+TARGETS = {
+    "e": "localhost:50055",
+    "f": "localhost:50056",
+}
+
+
+def load_stubs(proto_dir):
+    """Generate Python stubs for proto/ into a temp dir and import them."""
+    out_dir = tempfile.mkdtemp(prefix="loadgen-")
+    args = [
+        "grpc_tools.protoc",
+        f"-I{proto_dir}",
+        f"--python_out={out_dir}",
+        f"--grpc_python_out={out_dir}",
+        os.path.join(proto_dir, "common.proto"),
+        os.path.join(proto_dir, "services.proto"),
+    ]
+    if protoc.main(args) != 0:
+        sys.exit("Failed to generate stubs from " + proto_dir)
+    sys.path.insert(0, out_dir)
+    import services_pb2
+    import services_pb2_grpc
+    return services_pb2, services_pb2_grpc
+
+
+def make_call(args, pb2, pb2_grpc, channel):
+    """Return an async function issuing one request to the selected service."""
+    if args.service == "e":
+        stub = pb2_grpc.ServiceEStub(channel)
+        request = pb2.ComputeRequest(operation=args.operation)
+        request.metadata.caller_service = "loadgen"
+        request.input_values.extend(random.uniform(-1000.0, 1000.0) for _ in range(args.values))
+
+        async def call():
+            request.metadata.request_id = uuid.uuid4().hex
+            response = await stub.Compute(request, timeout=args.timeout)
+            return response.status.success
+    elif args.rpc == "batch":
+        stub = pb2_grpc.ServiceFStub(channel)
+
+        async def call():
+            request = pb2.LegacyDataBatchRequest(table_name=args.table)
+            request.record_ids.extend(
+                f"record-{random.randrange(args.records)}" for _ in range(args.batch_size))
+            request.metadata.caller_service = "loadgen"
+            request.metadata.request_id = uuid.uuid4().hex
+            response = await stub.FetchLegacyDataBatch(request, timeout=args.timeout)
+            return response.status.success
+    elif args.rpc == "stream":
+        stub = pb2_grpc.ServiceFStub(channel)
+
+        async def call():
+            # String order, so start at a random record and read batch-size records on
+            request = pb2.LegacyDataRangeRequest(
+                table_name=args.table,
+                start_record_id=f"record-{random.randrange(args.records)}",
+                limit=args.batch_size,
+            )
+            request.metadata.caller_service = "loadgen"
+            request.metadata.request_id = uuid.uuid4().hex
+            async for _ in stub.StreamLegacyData(request, timeout=args.timeout):
+                pass
+            return True
+    else:
+        stub = pb2_grpc.ServiceFStub(channel)
+
+        async def call():
+            request = pb2.LegacyDataRequest(
+                record_id=f"record-{random.randrange(args.records)}",
+                table_name=args.table,
+            )
+            request.metadata.caller_service = "loadgen"
+            request.metadata.request_id = uuid.uuid4().hex
+            response = await stub.FetchLegacyData(request, timeout=args.timeout)
+            return response.status.success
+
+    return call
+
+
+def percentile(sorted_values, p):
+    if not sorted_values:
+        return float("nan")
+    index = min(len(sorted_values) - 1, int(p / 100.0 * len(sorted_values)))
+    return sorted_values[index]
+
+
+async def run_fixed_rate(call, rps, duration, max_in_flight):
+    """Send at a fixed rate for duration seconds and collect latencies."""
+    latencies = []
+    errors = 0
+    unsuccessful = 0
+    skipped = 0
+    in_flight = set()
+
+    async def one(intended):
+        nonlocal errors, unsuccessful
+        try:
+            # An answered call is not a load failure, whatever its status says
+            if not await call():
+                unsuccessful += 1
+        except grpc.RpcError:
+            errors += 1
+        latencies.append((time.perf_counter() - intended) * 1000.0)
+
+    interval = 1.0 / rps
+    total = int(rps * duration)
+    start = time.perf_counter()
+    for i in range(total):
+        intended = start + i * interval
+        delay = intended - time.perf_counter()
+        if delay > 0:
+            await asyncio.sleep(delay)
+        if len(in_flight) >= max_in_flight:
+            # The server is not keeping up; count the request as failed
+            # rather than let the schedule slip
+            skipped += 1
+            continue
+        task = asyncio.create_task(one(intended))
+        in_flight.add(task)
+        task.add_done_callback(in_flight.discard)
+
+    if in_flight:
+        await asyncio.wait(in_flight)
+    elapsed = time.perf_counter() - start
+
+    latencies.sort()
+    return {
+        "target_rps": rps,
+        "achieved_rps": len(latencies) / elapsed if elapsed > 0 else 0.0,
+        "requests": total,
+        "errors": errors + skipped,
+        "unsuccessful": unsuccessful,
+        "p50": percentile(latencies, 50),
+        "p99": percentile(latencies, 99),
+        "p999": percentile(latencies, 99.9),
+        "max": latencies[-1] if latencies else float("nan"),
+    }
+
+
+def print_header():
+    print(f"{'target_rps':>10} {'achieved':>10} {'errors':>8} {'unsuccessful':>12} "
+          f"{'p50_ms':>9} {'p99_ms':>9} {'p999_ms':>9} {'max_ms':>9}")
+
+
+def print_result(r):
+    print(f"{r['target_rps']:>10.0f} {r['achieved_rps']:>10.1f} {r['errors']:>8d} {r['unsuccessful']:>12d} "
+          f"{r['p50']:>9.2f} {r['p99']:>9.2f} {r['p999']:>9.2f} {r['max']:>9.2f}", flush=True)
+
+
+def sustainable(r, args):
+    error_rate = r["errors"] / r["requests"] if r["requests"] else 1.0
+    return (r["p99"] <= args.slo_ms and error_rate <= args.max_error_rate
+            and r["achieved_rps"] >= 0.95 * r["target_rps"])
+
+
+async def main_async(args):
+    pb2, pb2_grpc = load_stubs(os.path.join(REPO_ROOT, "proto"))
+    target = args.target or TARGETS[args.service]
+
+    async with aio.insecure_channel(target) as channel:
+        call = make_call(args, pb2, pb2_grpc, channel)
+
+        # Warm up the connection and the server's caches before measuring
+        await run_fixed_rate(call, min(args.rps, 100), 1.0, args.max_in_flight)
+
+        print(f"Target: {target} (service-{args.service})")
+        print_header()
+
+        if not args.ramp:
+            print_result(await run_fixed_rate(call, args.rps, args.duration, args.max_in_flight))
+            return
+
+        start, stop, step = (float(x) for x in args.ramp.split(":"))
+        best = None
+        rps = start
+        while rps <= stop:
+            result = await run_fixed_rate(call, rps, args.duration, args.max_in_flight)
+            print_result(result)
+            if not sustainable(result, args):
+                break
+            best = result
+            rps += step
+
+        if best:
+            print(f"Max sustainable throughput: {best['target_rps']:.0f} rps "
+                  f"(p99 {best['p99']:.2f} ms <= {args.slo_ms} ms)")
+        else:
+            print(f"No sustainable rate found at or above {start:.0f} rps")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--service", choices=sorted(TARGETS), default="e")
+    parser.add_argument("--target", help="host:port (default: the service's local port)")
+    parser.add_argument("--rps", type=float, default=200.0, help="Fixed request rate")
+    parser.add_argument("--duration", type=float, default=10.0, help="Seconds per rate step")
+    parser.add_argument("--ramp", help="START:STOP:STEP rates to search for max throughput")
+    parser.add_argument("--slo-ms", type=float, default=50.0, help="p99 limit for the ramp")
+    parser.add_argument("--max-error-rate", type=float, default=0.01)
+    parser.add_argument("--max-in-flight", type=int, default=10000)
+    parser.add_argument("--timeout", type=float, default=5.0, help="Per-request deadline (s)")
+    parser.add_argument("--operation", default="transform", help="Compute operation (service e)")
+    parser.add_argument("--values", type=int, default=100, help="Input values per Compute")
+    parser.add_argument("--table", default="analytics_reference", help="Table (service f)")
+    parser.add_argument("--records", type=int, default=1000, help="Distinct record ids (service f)")
+    parser.add_argument("--rpc", choices=["unary", "batch", "stream"], default="unary",
+                        help="FetchLegacyData, FetchLegacyDataBatch or StreamLegacyData (service f)")
+    parser.add_argument("--batch-size", type=int, default=100,
+                        help="Records per batch or stream call (service f)")
+    args = parser.parse_args()
+    asyncio.run(main_async(args))
+
+
+if __name__ == "__main__":
+    main()